@@ -69,6 +69,25 @@ else
   "$ROOT/ci/bin/Projucer.exe" --resave "$ROOT/plugin/$PLUGIN.jucer"
 fi
 
+# Run the tests
+if [ "$OS" = "linux" ]; then
+  "$ROOT/ci/bin/Projucer" --resave "$ROOT/tools/FastMathTest/FastMathTest.jucer"
+  cd "$ROOT/tools/FastMathTest/Builds/LinuxMakefile"
+  make CONFIG=Release
+  ./build/FastMathTest || exit 1
+
+  # Render the fixtures so BulkRender keeps building and the patches keep
+  # loading. There are no references checked in yet, once there are, make
+  # them with --golden --out=References and the same options, and add
+  # --verify=References here. The fixtures leave the LFOs off, the sample
+  # and hold and noise shapes aren't seeded so they'd never match
+  "$ROOT/ci/bin/Projucer" --resave "$ROOT/tools/BulkRender/BulkRender.jucer"
+  cd "$ROOT/tools/BulkRender/Builds/LinuxMakefile"
+  make CONFIG=Release
+  cd "$ROOT/tools/BulkRender/Fixtures"
+  xvfb-run -a "$ROOT/tools/BulkRender/Builds/LinuxMakefile/build/BulkRender" --render --patches=Patches --midi=Midi --rate=48000 --block=512 --out="$ROOT/ci/bin/Renders" || exit 1
+fi
+
 # Build mac version
 if [ "$OS" = "mac" ]; then
   cd "$ROOT/plugin/Builds/MacOSX"
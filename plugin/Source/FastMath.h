@@ -0,0 +1,289 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Cheaper stand ins for the std::pow and std::log based conversions that
+    run per voice every block: pitch to frequency, decibels to gain and back,
+    and tanh.
+
+    exp2 is within 3e-7 of the exact result for its input, relative to it.
+    log2 is within 3e-7, relative once the result is over 1. Pitch is within
+    0.002 cents, gain within 0.00001 dB and tanh within 3e-7.
+
+    The array versions work four at a time with SSE2, or NEON on 64 bit ARM,
+    and one at a time elsewhere, to the same bounds. tools/FastMathTest
+    checks both.
+*/
+namespace FastMath
+{
+    /** 2^x, for x in about -126 to 127 */
+    inline float exp2 (float x) noexcept
+    {
+        x = juce::jlimit (-126.0f, 127.0f, x);
+
+        // Round to the nearest whole power, leaving a fraction in -0.5 to 0.5
+        auto i = std::floor (x + 0.5f);
+        auto f = (x - i) * 0.69314718056f;
+
+        // Taylor series of e^f, the seventh term would be under 1.2e-7
+        auto p = 1.0f + f * (1.0f + f * (1.0f / 2.0f + f * (1.0f / 6.0f + f * (1.0f / 24.0f
+                      + f * (1.0f / 120.0f + f * (1.0f / 720.0f))))));
+
+        auto bits = juce::uint32 (int (i) + 127) << 23;
+        float scale;
+        std::memcpy (&scale, &bits, sizeof (scale));
+
+        return p * scale;
+    }
+
+    /** log2 (x), for normal x > 0 */
+    inline float log2 (float x) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+
+        // Split into exponent and a mantissa in sqrt (0.5) to sqrt (2)
+        auto shifted = bits + (0x3f800000u - 0x3f3504f3u);
+        auto e       = float (int (shifted >> 23) - 127);
+        bits         = (shifted & 0x007fffffu) + 0x3f3504f3u;
+
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+
+        // ln m = 2 atanh s, with |s| under 0.172
+        auto s  = (m - 1.0f) / (m + 1.0f);
+        auto s2 = s * s;
+        auto ln = 2.0f * s * (1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f))));
+
+        return e + ln * 1.44269504089f;
+    }
+
+    //==============================================================================
+    inline float noteToHz (float note) noexcept
+    {
+        return 440.0f * exp2 ((note - 69.0f) * (1.0f / 12.0f));
+    }
+
+    inline float hzToNote (float hz) noexcept
+    {
+        return 69.0f + 12.0f * log2 (hz * (1.0f / 440.0f));
+    }
+
+    /** Same as juce::Decibels::decibelsToGain */
+    inline float dbToGain (float db, float minusInfinityDb = -100.0f) noexcept
+    {
+        // log2 (10) / 20
+        return db > minusInfinityDb ? exp2 (db * 0.16609640474f) : 0.0f;
+    }
+
+    /** Same as juce::Decibels::gainToDecibels */
+    inline float gainToDb (float gain, float minusInfinityDb = -100.0f) noexcept
+    {
+        // 20 / log2 (10)
+        return gain > 0.0f ? std::max (minusInfinityDb, log2 (gain) * 6.02059991328f) : minusInfinityDb;
+    }
+
+    /** tanh, for any x */
+    inline float tanh (float x) noexcept
+    {
+        x = juce::jlimit (-9.0f, 9.0f, x);
+
+        // 2 x log2 (e)
+        return 1.0f - 2.0f / (exp2 (x * 2.88539008178f) + 1.0f);
+    }
+
+    //==============================================================================
+    /** The same steps as above on four lanes at once */
+    namespace Simd
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        using Vec  = __m128;
+        using Bits = __m128i;
+
+        inline Vec  load (const float* p) noexcept          { return _mm_loadu_ps (p); }
+        inline void store (float* p, Vec v) noexcept        { _mm_storeu_ps (p, v); }
+        inline Vec  expand (float x) noexcept               { return _mm_set1_ps (x); }
+
+        inline Vec  add (Vec a, Vec b) noexcept             { return _mm_add_ps (a, b); }
+        inline Vec  sub (Vec a, Vec b) noexcept             { return _mm_sub_ps (a, b); }
+        inline Vec  mul (Vec a, Vec b) noexcept             { return _mm_mul_ps (a, b); }
+        inline Vec  div (Vec a, Vec b) noexcept             { return _mm_div_ps (a, b); }
+        inline Vec  min (Vec a, Vec b) noexcept             { return _mm_min_ps (a, b); }
+        inline Vec  max (Vec a, Vec b) noexcept             { return _mm_max_ps (a, b); }
+
+        /** a > b ? x : y */
+        inline Vec  selectGreater (Vec a, Vec b, Vec x, Vec y) noexcept
+        {
+            auto m = _mm_cmpgt_ps (a, b);
+            return _mm_or_ps (_mm_and_ps (m, x), _mm_andnot_ps (m, y));
+        }
+
+        inline Bits toBits (Vec v) noexcept                 { return _mm_castps_si128 (v); }
+        inline Vec  fromBits (Bits b) noexcept              { return _mm_castsi128_ps (b); }
+        inline Bits truncate (Vec v) noexcept               { return _mm_cvttps_epi32 (v); }
+        inline Vec  toFloat (Bits b) noexcept               { return _mm_cvtepi32_ps (b); }
+        inline Bits addBits (Bits b, int n) noexcept        { return _mm_add_epi32 (b, _mm_set1_epi32 (n)); }
+        inline Bits andBits (Bits b, int n) noexcept        { return _mm_and_si128 (b, _mm_set1_epi32 (n)); }
+        inline Bits shiftUp23 (Bits b) noexcept             { return _mm_slli_epi32 (b, 23); }
+        inline Bits shiftDown23 (Bits b) noexcept           { return _mm_srli_epi32 (b, 23); }
+
+        static constexpr int lanes = 4;
+       #elif JUCE_USE_ARM_NEON && defined (__aarch64__)
+        using Vec  = float32x4_t;
+        using Bits = int32x4_t;
+
+        inline Vec  load (const float* p) noexcept          { return vld1q_f32 (p); }
+        inline void store (float* p, Vec v) noexcept        { vst1q_f32 (p, v); }
+        inline Vec  expand (float x) noexcept               { return vdupq_n_f32 (x); }
+
+        inline Vec  add (Vec a, Vec b) noexcept             { return vaddq_f32 (a, b); }
+        inline Vec  sub (Vec a, Vec b) noexcept             { return vsubq_f32 (a, b); }
+        inline Vec  mul (Vec a, Vec b) noexcept             { return vmulq_f32 (a, b); }
+        inline Vec  div (Vec a, Vec b) noexcept             { return vdivq_f32 (a, b); }
+        inline Vec  min (Vec a, Vec b) noexcept             { return vminq_f32 (a, b); }
+        inline Vec  max (Vec a, Vec b) noexcept             { return vmaxq_f32 (a, b); }
+
+        /** a > b ? x : y */
+        inline Vec  selectGreater (Vec a, Vec b, Vec x, Vec y) noexcept
+        {
+            return vbslq_f32 (vcgtq_f32 (a, b), x, y);
+        }
+
+        inline Bits toBits (Vec v) noexcept                 { return vreinterpretq_s32_f32 (v); }
+        inline Vec  fromBits (Bits b) noexcept              { return vreinterpretq_f32_s32 (b); }
+        inline Bits truncate (Vec v) noexcept               { return vcvtq_s32_f32 (v); }
+        inline Vec  toFloat (Bits b) noexcept               { return vcvtq_f32_s32 (b); }
+        inline Bits addBits (Bits b, int n) noexcept        { return vaddq_s32 (b, vdupq_n_s32 (n)); }
+        inline Bits andBits (Bits b, int n) noexcept        { return vandq_s32 (b, vdupq_n_s32 (n)); }
+        inline Bits shiftUp23 (Bits b) noexcept             { return vshlq_n_s32 (b, 23); }
+        inline Bits shiftDown23 (Bits b) noexcept           { return vreinterpretq_s32_u32 (vshrq_n_u32 (vreinterpretq_u32_s32 (b), 23)); }
+
+        static constexpr int lanes = 4;
+       #else
+        using Vec  = float;
+        using Bits = juce::int32;
+
+        inline Vec  load (const float* p) noexcept          { return *p; }
+        inline void store (float* p, Vec v) noexcept        { *p = v; }
+        inline Vec  expand (float x) noexcept               { return x; }
+
+        inline Vec  add (Vec a, Vec b) noexcept             { return a + b; }
+        inline Vec  sub (Vec a, Vec b) noexcept             { return a - b; }
+        inline Vec  mul (Vec a, Vec b) noexcept             { return a * b; }
+        inline Vec  div (Vec a, Vec b) noexcept             { return a / b; }
+        inline Vec  min (Vec a, Vec b) noexcept             { return std::min (a, b); }
+        inline Vec  max (Vec a, Vec b) noexcept             { return std::max (a, b); }
+
+        /** a > b ? x : y */
+        inline Vec  selectGreater (Vec a, Vec b, Vec x, Vec y) noexcept { return a > b ? x : y; }
+
+        inline Bits toBits (Vec v) noexcept                 { Bits b; std::memcpy (&b, &v, sizeof (b)); return b; }
+        inline Vec  fromBits (Bits b) noexcept              { Vec v; std::memcpy (&v, &b, sizeof (v)); return v; }
+        inline Bits truncate (Vec v) noexcept               { return Bits (v); }
+        inline Vec  toFloat (Bits b) noexcept               { return Vec (b); }
+        inline Bits addBits (Bits b, int n) noexcept        { return Bits (juce::uint32 (b) + juce::uint32 (n)); }
+        inline Bits andBits (Bits b, int n) noexcept        { return b & n; }
+        inline Bits shiftUp23 (Bits b) noexcept             { return Bits (juce::uint32 (b) << 23); }
+        inline Bits shiftDown23 (Bits b) noexcept           { return Bits (juce::uint32 (b) >> 23); }
+
+        static constexpr int lanes = 1;
+       #endif
+
+        inline Vec exp2 (Vec x) noexcept
+        {
+            x = min (max (x, expand (-126.0f)), expand (127.0f));
+
+            // floor (x + 0.5), truncating once it's positive
+            auto i = addBits (truncate (add (x, expand (127.5f))), -127);
+            auto f = mul (sub (x, toFloat (i)), expand (0.69314718056f));
+
+            auto p = expand (1.0f / 720.0f);
+            p = add (mul (p, f), expand (1.0f / 120.0f));
+            p = add (mul (p, f), expand (1.0f / 24.0f));
+            p = add (mul (p, f), expand (1.0f / 6.0f));
+            p = add (mul (p, f), expand (1.0f / 2.0f));
+            p = add (mul (p, f), expand (1.0f));
+            p = add (mul (p, f), expand (1.0f));
+
+            return mul (p, fromBits (shiftUp23 (addBits (i, 127))));
+        }
+
+        inline Vec log2 (Vec x) noexcept
+        {
+            auto shifted = addBits (toBits (x), int (0x3f800000u - 0x3f3504f3u));
+            auto e       = toFloat (addBits (shiftDown23 (shifted), -127));
+            auto m       = fromBits (addBits (andBits (shifted, 0x007fffff), 0x3f3504f3));
+
+            auto one = expand (1.0f);
+            auto s   = div (sub (m, one), add (m, one));
+            auto s2  = mul (s, s);
+
+            auto p = expand (1.0f / 7.0f);
+            p = add (mul (p, s2), expand (1.0f / 5.0f));
+            p = add (mul (p, s2), expand (1.0f / 3.0f));
+            p = add (mul (p, s2), one);
+
+            return add (e, mul (mul (s, p), expand (2.0f * 1.44269504089f)));
+        }
+
+        /** Runs vec over whole registers and scalar over what's left */
+        template <typename VecFn, typename ScalarFn>
+        inline void apply (const float* in, float* out, int num, VecFn vec, ScalarFn scalar) noexcept
+        {
+            int i = 0;
+
+            for (; i + lanes <= num; i += lanes)
+                store (out + i, vec (load (in + i)));
+
+            for (; i < num; i++)
+                out[i] = scalar (in[i]);
+        }
+    }
+
+    //==============================================================================
+    /** Array versions of the above, out may be the same as in */
+    inline void noteToHz (const float* notes, float* hz, int num) noexcept
+    {
+        using namespace Simd;
+        apply (notes, hz, num,
+               [] (auto n) { return mul (expand (440.0f), Simd::exp2 (mul (sub (n, expand (69.0f)), expand (1.0f / 12.0f)))); },
+               [] (float n) { return noteToHz (n); });
+    }
+
+    inline void dbToGain (const float* db, float* gain, int num, float minusInfinityDb = -100.0f) noexcept
+    {
+        using namespace Simd;
+        apply (db, gain, num,
+               [=] (auto d) { return selectGreater (d, expand (minusInfinityDb), Simd::exp2 (mul (d, expand (0.16609640474f))), expand (0.0f)); },
+               [=] (float d) { return dbToGain (d, minusInfinityDb); });
+    }
+
+    inline void gainToDb (const float* gain, float* db, int num, float minusInfinityDb = -100.0f) noexcept
+    {
+        using namespace Simd;
+        apply (gain, db, num,
+               [=] (auto g)
+               {
+                   auto minDb = expand (minusInfinityDb);
+
+                   // A zero gain goes through log2 as the smallest normal, then is replaced
+                   auto safe = max (g, expand (std::numeric_limits<float>::min()));
+                   return selectGreater (g, expand (0.0f), max (minDb, mul (Simd::log2 (safe), expand (6.02059991328f))), minDb);
+               },
+               [=] (float g) { return gainToDb (g, minusInfinityDb); });
+    }
+
+    inline void tanh (const float* in, float* out, int num) noexcept
+    {
+        using namespace Simd;
+        apply (in, out, num,
+               [] (auto x)
+               {
+                   x = min (max (x, expand (-9.0f)), expand (9.0f));
+                   auto one = expand (1.0f);
+                   return sub (one, div (expand (2.0f), add (Simd::exp2 (mul (x, expand (2.88539008178f))), one)));
+               },
+               [] (float x) { return tanh (x); });
+    }
+}
@@ -0,0 +1,33 @@
+#include "GlobalSettings.h"
+
+//==============================================================================
+GlobalSettings::GlobalSettings()
+{
+    juce::PropertiesFile::Options options;
+    options.applicationName     = "VirtualAnalog";
+    options.filenameSuffix      = ".settings";
+    options.folderName          = "SocaLabs/VirtualAnalog";
+    options.osxLibrarySubFolder = "Application Support";
+    options.processLock         = &processLock;
+
+    properties = std::make_unique<juce::PropertiesFile> (options);
+}
+
+int GlobalSettings::getInt (const juce::String& key, int defaultValue) const
+{
+    const juce::ScopedLock sl (lock);
+    return properties->getIntValue (key, defaultValue);
+}
+
+bool GlobalSettings::getBool (const juce::String& key, bool defaultValue) const
+{
+    const juce::ScopedLock sl (lock);
+    return properties->getBoolValue (key, defaultValue);
+}
+
+void GlobalSettings::setValue (const juce::String& key, const juce::var& value)
+{
+    const juce::ScopedLock sl (lock);
+    properties->setValue (key, value);
+    properties->saveIfNeeded();
+}
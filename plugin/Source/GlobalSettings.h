@@ -0,0 +1,26 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Options that apply to the whole process rather than to one instance or
+    patch, like how many worker threads to run. Stored in one settings file
+    shared by every instance. Hold it with a juce::SharedResourcePointer.
+*/
+class GlobalSettings
+{
+public:
+    GlobalSettings();
+
+    int getInt (const juce::String& key, int defaultValue) const;
+    bool getBool (const juce::String& key, bool defaultValue) const;
+
+    void setValue (const juce::String& key, const juce::var& value);
+
+private:
+    mutable juce::CriticalSection lock;
+    juce::InterProcessLock processLock { "VirtualAnalogSettings" };
+    std::unique_ptr<juce::PropertiesFile> properties;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GlobalSettings)
+};
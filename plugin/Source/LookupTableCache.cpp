@@ -0,0 +1,55 @@
+#include "LookupTableCache.h"
+
+//==============================================================================
+LookupTableCache::Tables::Tables (double sampleRate_)
+    : sampleRate (sampleRate_)
+{
+}
+
+void LookupTableCache::Tables::build()
+{
+    tables = OscillatorTables::create (sampleRate);
+    ready.signal();
+}
+
+//==============================================================================
+LookupTableCache::LookupTableCache()
+{
+}
+
+LookupTableCache::~LookupTableCache()
+{
+    pool.removeAllJobs (false, -1);
+}
+
+LookupTableCache::Tables::Ptr LookupTableCache::get (double sampleRate)
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto t : tables)
+        if (juce::approximatelyEqual (t->sampleRate, sampleRate))
+            return t;
+
+    Tables::Ptr t = new Tables (sampleRate);
+    tables.add (t);
+
+    pool.addJob ([t] { t->build(); });
+
+    return t;
+}
+
+void LookupTableCache::addJob (std::function<void()> job)
+{
+    pool.addJob (std::move (job));
+}
+
+void LookupTableCache::purge()
+{
+    const juce::ScopedLock sl (lock);
+
+    // The cache holds one reference, anything above that is a plugin instance
+    // or a pending build job
+    for (int i = tables.size(); --i >= 0;)
+        if (tables.getObjectPointerUnchecked (i)->getReferenceCount() == 1)
+            tables.remove (i);
+}
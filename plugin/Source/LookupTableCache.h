@@ -0,0 +1,62 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OscillatorTables.h"
+
+//==============================================================================
+/** Process wide cache of oscillator tables, keyed by sample rate.
+    Hold it with a juce::SharedResourcePointer so every plugin instance in the
+    process sees the same cache. Tables are built on a background thread and
+    are immutable once ready, so any number of voices can read them.
+*/
+class LookupTableCache
+{
+public:
+    LookupTableCache();
+    ~LookupTableCache();
+
+    //==============================================================================
+    class Tables : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Tables>;
+
+        Tables (double sampleRate);
+
+        bool isReady() const                        { return ready.wait (0); }
+        void waitUntilReady() const                 { ready.wait (-1); }
+
+        const OscillatorTables& get() const         { jassert (isReady()); return *tables; }
+
+        const double sampleRate;
+
+    private:
+        friend class LookupTableCache;
+
+        void build();
+
+        std::unique_ptr<OscillatorTables> tables;
+        juce::WaitableEvent ready { true };
+
+        JUCE_DECLARE_NON_COPYABLE (Tables)
+    };
+
+    //==============================================================================
+    /** Returns the tables for a sample rate, starting a background build if
+        nobody has asked for this rate yet. Call waitUntilReady() before use.
+    */
+    Tables::Ptr get (double sampleRate);
+
+    /** Drops any tables no longer referenced by a plugin instance */
+    void purge();
+
+    /** Runs a job on the same background thread the tables are built on */
+    void addJob (std::function<void()> job);
+
+private:
+    juce::CriticalSection lock;
+    juce::ReferenceCountedArray<Tables> tables;
+    juce::ThreadPool pool { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LookupTableCache)
+};
@@ -0,0 +1,149 @@
+#include "MemoryLock.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+namespace
+{
+    /** How many times each page is locked, across every MemoryLock in the process */
+    struct LockedPages
+    {
+        juce::CriticalSection lock;
+        std::map<uintptr_t, int> counts;
+    };
+
+    LockedPages& getLockedPages()
+    {
+        static LockedPages pages;
+        return pages;
+    }
+
+    bool lockPages (uintptr_t start, size_t size)
+    {
+       #if JUCE_WINDOWS
+        return VirtualLock (reinterpret_cast<void*> (start), size) != 0;
+       #else
+        return mlock (reinterpret_cast<const void*> (start), size) == 0;
+       #endif
+    }
+
+    void unlockPages (uintptr_t start, size_t size)
+    {
+       #if JUCE_WINDOWS
+        VirtualUnlock (reinterpret_cast<void*> (start), size);
+       #else
+        munlock (reinterpret_cast<const void*> (start), size);
+       #endif
+    }
+
+    juce::String getLastError()
+    {
+       #if JUCE_WINDOWS
+        return "error " + juce::String (int (GetLastError()));
+       #else
+        return std::strerror (errno);
+       #endif
+    }
+}
+
+//==============================================================================
+size_t MemoryLock::getPageSize()
+{
+   #if JUCE_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo (&info);
+    return size_t (info.dwPageSize);
+   #else
+    return size_t (sysconf (_SC_PAGESIZE));
+   #endif
+}
+
+void MemoryLock::prefault (const void* data, size_t size)
+{
+    if (data == nullptr || size == 0)
+        return;
+
+    auto page = getPageSize();
+    auto p    = static_cast<const volatile char*> (data);
+
+    for (size_t i = 0; i < size; i += page)
+        (void) p[i];
+
+    (void) p[size - 1];
+}
+
+bool MemoryLock::lock (const void* data, size_t size)
+{
+    if (data == nullptr || size == 0)
+        return true;
+
+    prefault (data, size);
+
+    // Only the pages wholly inside the block
+    auto page  = uintptr_t (getPageSize());
+    auto start = (reinterpret_cast<uintptr_t> (data) + page - 1) & ~(page - 1);
+    auto end   = (reinterpret_cast<uintptr_t> (data) + size) & ~(page - 1);
+
+    if (end <= start)
+        return true;
+
+    auto& pages = getLockedPages();
+    const juce::ScopedLock sl (pages.lock);
+
+    if (! lockPages (start, size_t (end - start)))
+    {
+        failedBytes += size_t (end - start);
+        juce::Logger::writeToLog ("Couldn't lock " + juce::File::descriptionOfSizeInBytes (juce::int64 (end - start))
+                                  + ": " + getLastError());
+        return false;
+    }
+
+    for (auto p = start; p < end; p += page)
+        pages.counts[p]++;
+
+    regions.push_back ({ start, end });
+    lockedBytes += size_t (end - start);
+    return true;
+}
+
+void MemoryLock::unlockAll()
+{
+    auto page   = uintptr_t (getPageSize());
+    auto& pages = getLockedPages();
+    const juce::ScopedLock sl (pages.lock);
+
+    for (auto& r : regions)
+    {
+        // Unlock runs of pages nobody else holds
+        auto runStart = r.start;
+
+        for (auto p = r.start; p < r.end; p += page)
+        {
+            auto it = pages.counts.find (p);
+            jassert (it != pages.counts.end());
+
+            if (--it->second == 0)
+            {
+                pages.counts.erase (it);
+                continue;
+            }
+
+            if (runStart < p)
+                unlockPages (runStart, size_t (p - runStart));
+
+            runStart = p + page;
+        }
+
+        if (runStart < r.end)
+            unlockPages (runStart, size_t (r.end - runStart));
+    }
+
+    regions.clear();
+    lockedBytes = 0;
+    failedBytes = 0;
+}
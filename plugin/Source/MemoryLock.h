@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Keeps blocks of memory resident, so the audio thread never waits on a page
+    fault the first time it reads a table or a voice. Every page of a block is
+    touched when it's added, and the pages lying wholly inside it are then
+    locked if the OS allows it. The partial pages at either end may belong to
+    something else, so they're only touched, and a block smaller than a page
+    isn't locked at all.
+
+    mlock and VirtualLock don't count, so every page locked through any
+    MemoryLock in the process is counted here instead, and only unlocked once
+    the last one holding it lets go. Locking is limited per process on most
+    systems, failures are logged and the block is still touched, but may be
+    paged out again later.
+*/
+class MemoryLock
+{
+public:
+    MemoryLock() = default;
+    ~MemoryLock()                           { unlockAll(); }
+
+    /** Returns false if the block was touched but couldn't be locked */
+    bool lock (const void* data, size_t size);
+    void unlockAll();
+
+    /** Bytes actually locked, and asked for but refused, in whole pages */
+    size_t getLockedBytes() const           { return lockedBytes; }
+    size_t getFailedBytes() const           { return failedBytes; }
+
+    /** Reads one byte of every page so it's mapped in */
+    static void prefault (const void* data, size_t size);
+
+private:
+    static size_t getPageSize();
+
+    struct Region
+    {
+        uintptr_t start, end;
+    };
+
+    std::vector<Region> regions;
+    size_t lockedBytes = 0, failedBytes = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (MemoryLock)
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** White noise from eight interleaved xorshift generators. The lanes don't
+    depend on each other, so the compiler turns each step of fill() into a
+    few vector shifts and xors instead of one call into juce::Random per
+    sample. The same seed always gives the same noise, however it is split
+    into blocks, lanes left over from one fill() start the next.
+*/
+class NoiseGenerator
+{
+public:
+    static constexpr int numLanes = 8;
+
+    NoiseGenerator()                        { setSeed (1); }
+
+    void setSeed (juce::uint32 seed)
+    {
+        // splitmix32 so neighbouring seeds give unrelated streams
+        for (auto& s : state)
+        {
+            seed += 0x9e3779b9u;
+            auto z = seed;
+            z = (z ^ (z >> 16)) * 0x85ebca6bu;
+            z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+            z = z ^ (z >> 16);
+            s = z != 0 ? z : 0x6d2b79f5u;
+        }
+
+        numPending = 0;
+    }
+
+    /** Fills a block with noise between -1 and 1 */
+    void fill (float* dst, int numSamples) noexcept
+    {
+        auto done = std::min (numPending, numSamples);
+        std::copy_n (pending + numLanes - numPending, done, dst);
+        numPending -= done;
+
+        for (; done < numSamples; done += numLanes)
+        {
+            step (pending);
+
+            auto todo = std::min (numLanes, numSamples - done);
+            std::copy_n (pending, todo, dst + done);
+            numPending = numLanes - todo;
+        }
+    }
+
+    /** Between 0 and 1, for picking start phases from the same stream */
+    float nextFloat() noexcept
+    {
+        auto& s = state[0];
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        return float (s >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    void step (float* out) noexcept
+    {
+        for (int i = 0; i < numLanes; i++)
+        {
+            auto s = state[i];
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            state[i] = s;
+
+            out[i] = float (juce::int32 (s)) * (1.0f / 2147483648.0f);
+        }
+    }
+
+    alignas (32) juce::uint32 state[numLanes];
+    alignas (32) float pending[numLanes] = {};
+    int numPending = 0;             // unused values at the end of pending
+};
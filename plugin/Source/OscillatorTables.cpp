@@ -0,0 +1,226 @@
+#include "OscillatorTables.h"
+
+namespace
+{
+    struct FileHeader
+    {
+        char magic[4];
+        juce::uint32 version;
+        double sampleRate;
+        juce::uint32 tableSize, notesPerTable, numLevels, numWaves;
+        juce::uint32 compact, numFloats, numShorts;
+        char reserved[20];
+    };
+
+    static_assert (sizeof (FileHeader) == 64, "Keep the table data 16 byte aligned");
+
+    const char fileMagic[4] = { 'V', 'A', 'O', 'T' };
+}
+
+//==============================================================================
+std::unique_ptr<OscillatorTables> OscillatorTables::create (double sampleRate, bool compact)
+{
+    std::unique_ptr<OscillatorTables> tables (new OscillatorTables (sampleRate, compact));
+
+    auto f = getCacheFile (sampleRate, compact);
+    if (! tables->load (f))
+    {
+        tables->build();
+        tables->save (f);
+    }
+
+    return tables;
+}
+
+OscillatorTables::OscillatorTables (double sampleRate_, bool compact_)
+    : sampleRate (sampleRate_), compact (compact_)
+{
+    // Work out where every level lives, floats first then shorts
+    for (int w = 0; w < numWaves; w++)
+    {
+        for (int level = 0; level < numLevels; level++)
+        {
+            auto& l = levels[w][level];
+
+            if (w == sine)
+            {
+                l = levels[sine][0];
+                if (level > 0)
+                    continue;
+            }
+
+            // Sine is one table used by every note, so it stays float
+            l.isShort = compact && w != sine && (level < firstHotLevel || level > lastHotLevel);
+
+            auto& count = l.isShort ? numShorts : numFloats;
+            l.offset = count;
+            count += tableSize + 1;
+        }
+    }
+
+    // Keep the shorts 16 byte aligned in the file
+    numFloats = (numFloats + 3) & ~size_t (3);
+}
+
+OscillatorTables::~OscillatorTables()
+{
+}
+
+size_t OscillatorTables::lockMemory() const
+{
+    std::call_once (lockOnce, [this]
+    {
+        memoryLock.lock (floatData, numFloats * sizeof (float));
+        memoryLock.lock (shortData, numShorts * sizeof (juce::int16));
+    });
+
+    return memoryLock.getLockedBytes();
+}
+
+juce::File OscillatorTables::getCacheFile (double sampleRate, bool compact)
+{
+   #if JUCE_MAC
+    auto dir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory).getChildFile ("Caches");
+   #else
+    auto dir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory);
+   #endif
+
+    return dir.getChildFile ("SocaLabs/VirtualAnalog/Tables")
+              .getChildFile (juce::String::formatted ("osc_v%d_%d%s.bin", fileVersion, juce::roundToInt (sampleRate), compact ? "c" : ""));
+}
+
+//==============================================================================
+bool OscillatorTables::load (const juce::File& f)
+{
+    if (! f.existsAsFile())
+        return false;
+
+    auto mm = std::make_unique<juce::MemoryMappedFile> (f, juce::MemoryMappedFile::readOnly);
+    if (mm->getData() == nullptr || mm->getSize() != sizeof (FileHeader) + numFloats * sizeof (float) + numShorts * sizeof (juce::int16))
+        return false;
+
+    auto header = (const FileHeader*) mm->getData();
+    if (memcmp (header->magic, fileMagic, sizeof (fileMagic)) != 0
+        || header->version       != juce::uint32 (fileVersion)
+        || header->sampleRate    != sampleRate
+        || header->tableSize     != juce::uint32 (tableSize)
+        || header->notesPerTable != juce::uint32 (notesPerTable)
+        || header->numLevels     != juce::uint32 (numLevels)
+        || header->numWaves      != juce::uint32 (numWaves)
+        || header->compact       != juce::uint32 (compact ? 1 : 0)
+        || header->numFloats     != juce::uint32 (numFloats)
+        || header->numShorts     != juce::uint32 (numShorts))
+        return false;
+
+    floatData = (const float*) juce::addBytesToPointer (mm->getData(), sizeof (FileHeader));
+    shortData = (const juce::int16*) (floatData + numFloats);
+    mapped = std::move (mm);
+    return true;
+}
+
+void OscillatorTables::save (const juce::File& f) const
+{
+    FileHeader header = {};
+    memcpy (header.magic, fileMagic, sizeof (fileMagic));
+    header.version          = juce::uint32 (fileVersion);
+    header.sampleRate       = sampleRate;
+    header.tableSize        = juce::uint32 (tableSize);
+    header.notesPerTable    = juce::uint32 (notesPerTable);
+    header.numLevels        = juce::uint32 (numLevels);
+    header.numWaves         = juce::uint32 (numWaves);
+    header.compact          = juce::uint32 (compact ? 1 : 0);
+    header.numFloats        = juce::uint32 (numFloats);
+    header.numShorts        = juce::uint32 (numShorts);
+
+    if (! f.getParentDirectory().createDirectory())
+        return;
+
+    // Write to a temp file and move it into place, other processes may be
+    // mapping or writing the same file
+    juce::TemporaryFile temp (f);
+
+    bool ok = false;
+    if (auto os = temp.getFile().createOutputStream())
+    {
+        ok = os->write (&header, sizeof (header))
+          && os->write (floatData, numFloats * sizeof (float))
+          && (numShorts == 0 || os->write (shortData, numShorts * sizeof (juce::int16)));
+
+        os->flush();
+        ok = ok && os->getStatus().wasOk();
+    }
+
+    if (ok)
+        temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+void OscillatorTables::build()
+{
+    floatStorage.assign (numFloats, 0.0f);
+    shortStorage.assign (numShorts, 0);
+    floatData = floatStorage.data();
+    shortData = shortStorage.data();
+
+    // Every harmonic is read from one sine cycle with (harmonic * index) & mask
+    std::vector<double> sineCycle ((size_t) tableSize);
+    for (int i = 0; i < tableSize; i++)
+        sineCycle[size_t (i)] = std::sin (juce::MathConstants<double>::twoPi * i / tableSize);
+
+    // Highest harmonic that stays below nyquist for the top note of a level
+    auto maxHarmonic = [this] (int level)
+    {
+        auto hz = 440.0 * std::pow (2.0, ((level + 1) * notesPerTable - 69) / 12.0);
+        return juce::jlimit (1, tableSize / 2 - 1, int (sampleRate / 2.0 / hz));
+    };
+
+    auto store = [&] (const Level& l, const std::vector<double>& src)
+    {
+        if (l.isShort)
+        {
+            auto dst = shortStorage.data() + l.offset;
+            for (int i = 0; i < tableSize; i++)
+                dst[i] = juce::int16 (juce::jlimit (-32767, 32767, juce::roundToInt (src[size_t (i)] / shortScale)));
+            dst[tableSize] = dst[0];
+        }
+        else
+        {
+            auto dst = floatStorage.data() + l.offset;
+            for (int i = 0; i < tableSize; i++)
+                dst[i] = float (src[size_t (i)]);
+            dst[tableSize] = dst[0];
+        }
+    };
+
+    // Levels are built from the top down, each one adds the harmonics the
+    // level above it had to leave out
+    auto fill = [&] (Wave w, std::function<double (int)> amplitude)
+    {
+        std::vector<double> acc ((size_t) tableSize);
+        int done = 0;
+
+        for (int level = numLevels; --level >= 0;)
+        {
+            int top = maxHarmonic (level);
+
+            for (int k = done + 1; k <= top; k++)
+            {
+                auto a = amplitude (k);
+                if (a == 0.0)
+                    continue;
+
+                for (int i = 0; i < tableSize; i++)
+                    acc[size_t (i)] += a * sineCycle[size_t ((k * i) & (tableSize - 1))];
+            }
+            done = std::max (done, top);
+
+            store (levels[w][level], acc);
+        }
+    };
+
+    const auto pi = juce::MathConstants<double>::pi;
+
+    store (levels[sine][0], sineCycle);
+    fill (triangle, [pi] (int k)    { return k % 2 == 0 ? 0.0 : ((k / 2) % 2 == 0 ? 1.0 : -1.0) * 8.0 / (pi * pi * k * k); });
+    fill (saw,      [pi] (int k)    { return -2.0 / (pi * k); });
+}
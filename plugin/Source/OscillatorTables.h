@@ -0,0 +1,137 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MemoryLock.h"
+
+//==============================================================================
+/** Band limited single cycle tables for the analog waveforms at one sample rate.
+    Every mip level of every wave lives in one flat block, so a generated set
+    can be written to disk as is and memory mapped back in on the next launch
+    instead of being rebuilt.
+
+    Only sine, triangle and saw are stored. Saw down is saw up read with a
+    negative gain and square is the difference of two saws half a cycle apart,
+    the same as the pulse wave at 50%. Sine has no harmonics to remove so all
+    its levels share one float table. In compact mode the other waves' levels
+    outside the range of notes normally played are stored as 16 bit, they are
+    converted to float as they are read.
+*/
+class OscillatorTables
+{
+public:
+    enum Wave
+    {
+        sine,
+        triangle,
+        saw,
+        numWaves
+    };
+
+    static constexpr int tableSize      = 2048;
+    static constexpr int notesPerTable  = 6;
+    static constexpr int numLevels      = 24;
+    static constexpr int fileVersion    = 3;
+
+    /** Levels outside this range are 16 bit in compact mode, about notes 24 to 101 */
+    static constexpr int firstHotLevel  = 4;
+    static constexpr int lastHotLevel   = 16;
+
+    /** Maps the cached tables for this rate, or builds and caches them */
+    static std::unique_ptr<OscillatorTables> create (double sampleRate, bool compact = true);
+
+    ~OscillatorTables();
+
+    double getSampleRate() const        { return sampleRate; }
+    bool isMapped() const               { return mapped != nullptr; }
+    bool isCompact() const              { return compact; }
+
+    /** Faults in and locks the tables, once for every user. Returns the bytes locked. */
+    size_t lockMemory() const;
+
+    /** One mip level. Exactly one of samples or shorts is set, both have one
+        guard sample at the end so lookups never have to wrap.
+    */
+    struct Table
+    {
+        const float* samples = nullptr;
+        const juce::int16* shorts = nullptr;
+        float gain = 1.0f;
+    };
+
+    /** Returns the mip level of a wave to use for a note */
+    Table getTable (Wave w, float note, float gain = 1.0f) const noexcept
+    {
+        auto level = juce::jlimit (0, numLevels - 1, int (std::floor (note)) / notesPerTable);
+        auto& l = levels[w][level];
+
+        Table t;
+        if (l.isShort)
+        {
+            t.shorts = shortData + l.offset;
+            t.gain   = gain * shortScale;
+        }
+        else
+        {
+            t.samples = floatData + l.offset;
+            t.gain    = gain;
+        }
+        return t;
+    }
+
+    static float lookup (const float* table, float phase) noexcept
+    {
+        auto pos  = phase * tableSize;
+        auto i    = int (pos);
+        auto frac = pos - float (i);
+
+        return table[i] + (table[i + 1] - table[i]) * frac;
+    }
+
+    /** Unscaled, multiply by Table::gain */
+    static float lookup (const juce::int16* table, float phase) noexcept
+    {
+        auto pos  = phase * tableSize;
+        auto i    = int (pos);
+        auto frac = pos - float (i);
+
+        auto s0 = float (table[i]);
+        auto s1 = float (table[i + 1]);
+
+        return s0 + (s1 - s0) * frac;
+    }
+
+private:
+    OscillatorTables (double sampleRate, bool compact);
+
+    static juce::File getCacheFile (double sampleRate, bool compact);
+
+    bool load (const juce::File& f);
+    void build();
+    void save (const juce::File& f) const;
+
+    /** Saw overshoots past 1, leave some headroom */
+    static constexpr float shortScale = 2.0f / 32767.0f;
+
+    struct Level
+    {
+        size_t offset = 0;
+        bool isShort = false;
+    };
+
+    const double sampleRate;
+    const bool compact;
+
+    Level levels[numWaves][numLevels];
+    size_t numFloats = 0, numShorts = 0;
+
+    std::vector<float> floatStorage;
+    std::vector<juce::int16> shortStorage;
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    const float* floatData = nullptr;
+    const juce::int16* shortData = nullptr;
+
+    mutable std::once_flag lockOnce;
+    mutable MemoryLock memoryLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OscillatorTables)
+};
@@ -15,17 +15,20 @@ public:
 
         addEnable (osc.enable);
 
-        addControl (new gin::Select (osc.wave), 0, 0);
+        addControl (wave = new gin::Select (osc.wave), 0, 0);
         addControl (new gin::Knob (osc.tune, true), 1, 0);
         addControl (new gin::Select (osc.voices), 2, 0);
         addControl (detune = new gin::Knob (osc.detune), 3, 0);
 
         addControl (pw = new gin::Knob (osc.pulsewidth), 0, 1);
-        addControl (new gin::Knob (osc.finetune, true), 1, 1);
+        addControl (frame = new gin::Knob (osc.frame), 0, 1);
+        addControl (fine = new gin::Knob (osc.finetune, true), 1, 1);
+        addControl (table = new gin::Select (osc.table), 1, 1);
         addControl (spread = new gin::Knob (osc.spread), 2, 1);
         addControl (trans = new gin::Knob (osc.voicesTrns, true), 3, 1);
 
         watchParam (osc.wave);
+        watchParam (osc.table);
         watchParam (osc.voices);
     }
 
@@ -34,16 +37,40 @@ public:
         gin::ParamBox::paramChanged();
 
         auto& osc = proc.oscParams[idx];
-        pw->setEnabled ((gin::Wave) int (osc.wave->getProcValue()) == gin::Wave::pulse);
+        auto isPulse = (gin::Wave) int (osc.wave->getProcValue()) == gin::Wave::pulse;
+        auto isTable = osc.table->getProcValue() > 0;
+
+        // A table swaps pulse width and fine tune for frame and table. With
+        // no table, the same table select moves to where pulse width would
+        // be unused.
+        wave->setEnabled (! isTable);
+        pw->setVisible (! isTable && isPulse);
+        fine->setVisible (! isTable);
+        frame->setVisible (isTable);
+        table->setVisible (isTable || ! isPulse);
+
+        placeTable();
 
         trans->setEnabled (osc.voices->getProcValue() > 1);
         detune->setEnabled (osc.voices->getProcValue() > 1);
         spread->setEnabled (osc.voices->getProcValue() > 1);
     }
 
+    void resized() override
+    {
+        gin::ParamBox::resized();
+        placeTable();
+    }
+
+    void placeTable()
+    {
+        auto isTable = proc.oscParams[idx].table->getProcValue() > 0;
+        table->setTopLeftPosition ((isTable ? fine : pw)->getPosition());
+    }
+
     VirtualAnalogAudioProcessor& proc;
     int idx = 0;
-    gin::ParamComponent::Ptr pw, trans, detune, spread;
+    gin::ParamComponent::Ptr wave, pw, trans, detune, spread, frame, fine, table;
 };
 
 //==============================================================================
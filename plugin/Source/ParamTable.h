@@ -0,0 +1,59 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Compile time description of a parameter. The tables of these in
+    PluginProcessor.cpp replace building every id, name and range by hand in
+    each instance.
+*/
+namespace ParamTable
+{
+    using TextFunction       = juce::String (*) (const gin::Parameter&, float);
+    using ConversionFunction = float (*) (float);
+
+    enum Flags
+    {
+        ext             = 1 << 0,   // automatable, addExtParam rather than addIntParam
+        onForFirst      = 1 << 1,   // default is on for the first of a group, off for the rest
+        symmetricSkew   = 1 << 2,
+        eased           = 1 << 3,   // eased rather than linear smoothing
+        beatRange       = 1 << 4,   // end of range is the last note duration
+        hzRange         = 1 << 5,   // end of range is in Hz, stored as a midi note
+        hzDefault       = 1 << 6,   // default is in Hz, stored as a midi note
+        gatePattern     = 1 << 7,   // default is the initial gate pattern
+    };
+
+    static constexpr int numSteps = 32;
+
+    template <typename T>
+    struct Def
+    {
+        gin::Parameter::Ptr T::* member;
+        const char* id;
+        const char* name;
+        const char* shortName;
+        const char* label;
+        float start, end, interval, skew;
+        float defaultValue;
+        float smoothing;
+        int flags;
+        TextFunction text;
+        ConversionFunction conversion;
+
+        /** Set instead of member for per step parameters, these are added
+            after the others with the steps interleaved.
+        */
+        gin::Parameter::Ptr (T::* steps)[numSteps] = nullptr;
+    };
+
+    /** Prefixes for a group of parameters. For indexed groups the number of
+        the group is added to the id and name, eg "osc1" and "OSC1 ".
+    */
+    struct Group
+    {
+        const char* idPrefix;
+        const char* namePrefix;
+        bool indexed;
+    };
+}
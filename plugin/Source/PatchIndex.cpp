@@ -0,0 +1,249 @@
+#include "PatchIndex.h"
+
+//==============================================================================
+PatchIndex::PatchIndex()
+    : juce::Thread ("PatchIndex")
+    , snapshot (std::make_shared<Snapshot>())
+{
+}
+
+PatchIndex::~PatchIndex()
+{
+    stopThread (5000);
+}
+
+void PatchIndex::setDirectory (const juce::File& dir)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        if (directory == dir)
+            return;
+
+        directory = dir;
+    }
+
+    auto s = makeSnapshot (loadIndex (dir));
+    {
+        const juce::ScopedLock sl (lock);
+        snapshot = s;
+    }
+    sendChangeMessage();
+
+    if (isThreadRunning())
+        notify();
+    else
+        startThread (2);
+}
+
+void PatchIndex::rescan()
+{
+    notify();
+}
+
+//==============================================================================
+juce::Array<PatchIndex::Entry> PatchIndex::findByPrefix (const juce::String& prefix) const
+{
+    auto s = getSnapshot();
+
+    auto itr = std::lower_bound (s->entries.begin(), s->entries.end(), prefix,
+                                 [] (const Entry& e, const juce::String& p) { return e.name.compareIgnoreCase (p) < 0; });
+
+    juce::Array<Entry> res;
+    for (; itr != s->entries.end() && itr->name.startsWithIgnoreCase (prefix); ++itr)
+        res.add (*itr);
+
+    return res;
+}
+
+juce::Array<PatchIndex::Entry> PatchIndex::findByTag (const juce::String& tag) const
+{
+    auto s = getSnapshot();
+
+    juce::Array<Entry> res;
+
+    auto itr = s->tags.find (tag.toLowerCase());
+    if (itr != s->tags.end())
+        for (auto idx : itr->second)
+            res.add (s->entries[idx]);
+
+    return res;
+}
+
+juce::StringArray PatchIndex::getAllTags() const
+{
+    auto s = getSnapshot();
+
+    juce::StringArray res;
+    for (auto& t : s->tags)
+        res.add (t.first);
+
+    return res;
+}
+
+int PatchIndex::getNumPatches() const
+{
+    return int (getSnapshot()->entries.size());
+}
+
+std::shared_ptr<const PatchIndex::Snapshot> PatchIndex::getSnapshot() const
+{
+    const juce::ScopedLock sl (lock);
+    return snapshot;
+}
+
+//==============================================================================
+void PatchIndex::run()
+{
+    while (! threadShouldExit())
+    {
+        juce::File dir;
+        {
+            const juce::ScopedLock sl (lock);
+            dir = directory;
+        }
+
+        auto old = getSnapshot();
+
+        std::map<juce::String, const Entry*> known;
+        for (auto& e : old->entries)
+            known[e.file.getFullPathName()] = &e;
+
+        std::vector<Entry> entries;
+        bool changed = false;
+
+        for (auto& f : dir.findChildFiles (juce::File::findFiles, false, "*.xml"))
+        {
+            if (threadShouldExit())
+                return;
+
+            auto itr = known.find (f.getFullPathName());
+            if (itr != known.end() && itr->second->modified == f.getLastModificationTime().toMilliseconds())
+            {
+                entries.push_back (*itr->second);
+            }
+            else
+            {
+                entries.push_back (readEntry (f));
+                changed = true;
+            }
+
+            if (itr != known.end())
+                known.erase (itr);
+        }
+
+        // Anything left over has been deleted
+        if (! known.empty())
+            changed = true;
+
+        if (changed)
+        {
+            saveIndex (dir, entries);
+
+            auto s = makeSnapshot (std::move (entries));
+            {
+                const juce::ScopedLock sl (lock);
+                if (directory == dir)
+                    snapshot = s;
+            }
+            sendChangeMessage();
+        }
+
+        // Saving, deleting or renaming a patch touches the folder, wait for
+        // that or a call to rescan
+        auto folderTime = dir.getLastModificationTime();
+
+        while (! threadShouldExit() && ! wait (1000))
+            if (dir.getLastModificationTime() != folderTime)
+                break;
+    }
+}
+
+std::shared_ptr<const PatchIndex::Snapshot> PatchIndex::makeSnapshot (std::vector<Entry> entries)
+{
+    auto s = std::make_shared<Snapshot>();
+
+    std::sort (entries.begin(), entries.end(),
+               [] (const Entry& a, const Entry& b) { return a.name.compareIgnoreCase (b.name) < 0; });
+
+    s->entries = std::move (entries);
+
+    for (size_t i = 0; i < s->entries.size(); i++)
+        for (auto& t : s->entries[i].tags)
+            s->tags[t.toLowerCase()].push_back (i);
+
+    return s;
+}
+
+PatchIndex::Entry PatchIndex::readEntry (const juce::File& f)
+{
+    Entry e;
+    e.file      = f;
+    e.modified  = f.getLastModificationTime().toMilliseconds();
+    e.name      = f.getFileNameWithoutExtension();
+
+    // Only the outer element is parsed, that's where the name and tags are
+    juce::XmlDocument doc (f);
+    if (auto xml = doc.getDocumentElement (true))
+    {
+        e.name   = xml->getStringAttribute ("name", e.name);
+        e.author = xml->getStringAttribute ("author");
+
+        e.tags.addTokens (xml->getStringAttribute ("tags"), " ,", "");
+        e.tags.trim();
+        e.tags.removeEmptyStrings();
+    }
+
+    return e;
+}
+
+//==============================================================================
+std::vector<PatchIndex::Entry> PatchIndex::loadIndex (const juce::File& dir)
+{
+    std::vector<Entry> entries;
+
+    juce::FileInputStream is (getIndexFile (dir));
+    if (! is.openedOk() || is.readInt() != indexVersion)
+        return entries;
+
+    auto num = is.readInt();
+    for (int i = 0; i < num && ! is.isExhausted(); i++)
+    {
+        Entry e;
+        e.file      = dir.getChildFile (is.readString());
+        e.modified  = is.readInt64();
+        e.name      = is.readString();
+        e.author    = is.readString();
+        e.tags      = juce::StringArray::fromLines (is.readString());
+        e.tags.removeEmptyStrings();
+
+        entries.push_back (std::move (e));
+    }
+
+    return entries;
+}
+
+void PatchIndex::saveIndex (const juce::File& dir, const std::vector<Entry>& entries)
+{
+    juce::TemporaryFile temp (getIndexFile (dir));
+
+    bool ok = false;
+    if (auto os = temp.getFile().createOutputStream())
+    {
+        ok = os->writeInt (indexVersion) && os->writeInt (int (entries.size()));
+
+        for (auto& e : entries)
+        {
+            ok = ok && os->writeString (e.file.getFileName())
+                    && os->writeInt64 (e.modified)
+                    && os->writeString (e.name)
+                    && os->writeString (e.author)
+                    && os->writeString (e.tags.joinIntoString ("\n"));
+        }
+
+        os->flush();
+        ok = ok && os->getStatus().wasOk();
+    }
+
+    if (ok)
+        temp.overwriteTargetFileWithTemporary();
+}
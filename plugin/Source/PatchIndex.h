@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Keeps a compact index of the patch library so the program list and the
+    browser can list and filter patches without opening every file. The index is saved next to the
+    patches and brought up to date on a background thread, only re-reading
+    files whose modification time changed. The thread checks again whenever
+    the folder's own modification time changes, which saving, deleting or
+    renaming a patch does. Hold it with a
+    juce::SharedResourcePointer, all instances share one index.
+*/
+class PatchIndex : public juce::ChangeBroadcaster,
+                   private juce::Thread
+{
+public:
+    PatchIndex();
+    ~PatchIndex() override;
+
+    struct Entry
+    {
+        juce::File file;
+        juce::int64 modified = 0;
+        juce::String name, author;
+        juce::StringArray tags;
+    };
+
+    /** Loads the saved index for a folder and starts checking it for changes */
+    void setDirectory (const juce::File& dir);
+
+    /** Checks the folder for changes now rather than waiting to notice the
+        folder change. Sends a change message if anything changed.
+    */
+    void rescan();
+
+    //==============================================================================
+    /** Patches whose name starts with prefix, sorted by name */
+    juce::Array<Entry> findByPrefix (const juce::String& prefix) const;
+
+    /** Patches with a tag, sorted by name */
+    juce::Array<Entry> findByTag (const juce::String& tag) const;
+
+    juce::StringArray getAllTags() const;
+    int getNumPatches() const;
+
+    static constexpr int indexVersion = 1;
+
+private:
+    struct Snapshot
+    {
+        std::vector<Entry> entries;                     // sorted by lower case name
+        std::map<juce::String, std::vector<size_t>> tags;  // lower case tag -> entries
+    };
+
+    void run() override;
+
+    static std::shared_ptr<const Snapshot> makeSnapshot (std::vector<Entry> entries);
+    static Entry readEntry (const juce::File& f);
+
+    static std::vector<Entry> loadIndex (const juce::File& dir);
+    static void saveIndex (const juce::File& dir, const std::vector<Entry>& entries);
+    static juce::File getIndexFile (const juce::File& dir)  { return dir.getChildFile (".patchindex"); }
+
+    std::shared_ptr<const Snapshot> getSnapshot() const;
+
+    mutable juce::CriticalSection lock;
+    juce::File directory;
+    std::shared_ptr<const Snapshot> snapshot;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PatchIndex)
+};
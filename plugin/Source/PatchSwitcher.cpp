@@ -0,0 +1,89 @@
+#include "PatchSwitcher.h"
+
+//==============================================================================
+PatchSwitcher::PatchSwitcher (const juce::CriticalSection& callbackLock_)
+    : callbackLock (callbackLock_)
+{
+}
+
+void PatchSwitcher::prepare (double sampleRate_)
+{
+    sampleRate = sampleRate_;
+
+    auto size = int (std::ceil (maxFadeTime * sampleRate));
+
+    tail.setSize (2, size);
+    fading.setSize (2, size);
+    tail.clear();
+    fading.clear();
+
+    fadePos    = 0;
+    fadeLength = 0;
+    switched   = false;
+}
+
+void PatchSwitcher::switchPatch (const std::function<void()>& applyPatch)
+{
+    const juce::ScopedLock sl (callbackLock);
+
+    applyPatch();
+    switched = true;
+}
+
+//==============================================================================
+void PatchSwitcher::process (juce::AudioSampleBuffer& buffer)
+{
+    auto numSamples  = buffer.getNumSamples();
+    auto numChannels = std::min (2, buffer.getNumChannels());
+    auto size        = tail.getNumSamples();
+
+    if (size == 0)
+        return;
+
+    if (switched.exchange (false))
+    {
+        // Fade out from the end of the old patch, the buffers are the same size so nothing allocates
+        std::swap (tail, fading);
+
+        fadePos    = 0;
+        fadeLength = std::min (size, int (fadeTime * sampleRate));
+    }
+
+    if (fadePos < fadeLength)
+    {
+        // Reading the old tail backwards carries on from its last sample without a jump
+        auto todo = std::min (numSamples, fadeLength - fadePos);
+
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            auto out = buffer.getWritePointer (ch);
+            auto old = fading.getReadPointer (ch);
+
+            for (int i = 0; i < todo; i++)
+            {
+                auto pos = fadePos + i;
+                auto g   = float (pos + 1) / float (fadeLength + 1);
+
+                out[i] = out[i] * g + old[size - 1 - pos] * (1.0f - g);
+            }
+        }
+
+        fadePos += todo;
+    }
+
+    // Keep the end of this block for the next switch
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        auto t = tail.getWritePointer (ch);
+
+        if (numSamples >= size)
+        {
+            std::copy_n (buffer.getReadPointer (ch, numSamples - size), size, t);
+        }
+        else
+        {
+            std::copy (t + numSamples, t + size, t);
+            std::copy_n (buffer.getReadPointer (ch), numSamples, t + size - numSamples);
+        }
+    }
+}
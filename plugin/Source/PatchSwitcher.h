@@ -0,0 +1,51 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Swaps a patch in between two blocks. The caller does the slow part, reading
+    and parsing, first, then switchPatch applies the result holding the
+    callback lock, so a block sees all of the old patch or all of the new one
+    and the host reads the new values as soon as the call returns.
+
+    The jump in the output where the patch changes is hidden by crossfading
+    the first block after it from a mirror of the end of the last one. All
+    the audio thread pays while nothing is switching is one atomic exchange
+    and keeping a copy of the end of each block.
+*/
+class PatchSwitcher
+{
+public:
+    /** callbackLock is the one the host holds around processBlock */
+    PatchSwitcher (const juce::CriticalSection& callbackLock);
+
+    void prepare (double sampleRate);
+
+    /** Length of the crossfade, 0 turns it off */
+    void setFadeTime (float seconds)        { fadeTime = juce::jlimit (0.0f, maxFadeTime, seconds); }
+
+    //==============================================================================
+    /** Any thread but the audio thread. Runs applyPatch holding the callback
+        lock and returns once it's done.
+    */
+    void switchPatch (const std::function<void()>& applyPatch);
+
+    /** Audio thread, at the end of a block */
+    void process (juce::AudioSampleBuffer& buffer);
+
+private:
+    static constexpr float maxFadeTime = 0.05f;
+
+    const juce::CriticalSection& callbackLock;
+
+    std::atomic<bool> switched { false };
+
+    double sampleRate = 44100.0;
+    std::atomic<float> fadeTime { 0.01f };
+
+    // The end of the last block, and the one being faded out from
+    juce::AudioSampleBuffer tail, fading;
+    int fadePos = 0, fadeLength = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (PatchSwitcher)
+};
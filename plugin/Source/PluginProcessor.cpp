@@ -14,13 +14,23 @@ static juce::String waveTextFunction (const gin::Parameter&, float v)
         case gin::Wave::pulse:       return "Pulse";
         case gin::Wave::square:      return "Square";
         case gin::Wave::noise:       return "Noise";
-        case gin::Wave::wavetable:
         default:
             jassertfalse;
             return {};
     }
 }
 
+static juce::String wavetableTextFunction (const gin::Parameter&, float v)
+{
+    if (int (v) == 0)
+        return "Off";
+
+    // Every instance holds the bank, so this only takes another reference
+    juce::SharedResourcePointer<WavetableBank> bank;
+    auto name = bank->getTableName (int (v) - 1);
+    return name.isEmpty() ? juce::String ("None") : name;
+}
+
 static juce::String lfoTextFunction (const gin::Parameter&, float v)
 {
     switch ((gin::LFO::WaveShape)int (v))
@@ -100,279 +110,421 @@ static juce::String glideModeTextFunction (const gin::Parameter&, float v)
     }
 }
 
+static float dbToGain (float in)        { return FastMath::dbToGain (in); }
+static float percentToUnit (float in)   { return in / 100.0f; }
+static float msToSeconds (float in)     { return in / 1000.0f; }
+static float noteToHz (float in)        { return FastMath::noteToHz (in); }
+
 //==============================================================================
-void VirtualAnalogAudioProcessor::OSCParams::setup (VirtualAnalogAudioProcessor& p, int idx)
+using namespace ParamTable;
+
+template <typename T, size_t N>
+void VirtualAnalogAudioProcessor::addParams (T& params, const Group& group, const Def<T> (&defs)[N], int idx)
 {
-    juce::String id = "osc" + juce::String (idx + 1);
-    juce::String nm = "OSC" + juce::String (idx + 1) + " ";
+    struct Info
+    {
+        const Def<T>* def;
+        int step;
+        juce::String uid, name, shortName, label;
+        juce::NormalisableRange<float> range;
+        float defaultValue;
+    };
+
+    // Ids, names and ranges are built once per process, every instance after
+    // the first only takes references to the same strings
+    static juce::CriticalSection lock;
+    static std::map<std::pair<const Group*, int>, std::vector<Info>> cache;
+
+    const juce::ScopedLock sl (lock);
+
+    auto& infos = cache[{ &group, idx }];
+    if (infos.empty())
+    {
+        juce::String id = group.idPrefix;
+        juce::String nm = group.namePrefix;
 
-    enable     = p.addIntParam (id + "enable",     nm + "Enable",      "Enable",    "", { 0.0, 1.0, 1.0, 1.0 }, idx == 0 ? 1.0f : 0.0f, 0.0f);
-    wave       = p.addIntParam (id + "wave",       nm + "Wave",        "Wave",      "", { 1.0, 7.0, 1.0, 1.0 }, 1.0, 0.0f, waveTextFunction);
-    voices     = p.addIntParam (id + "unison",     nm + "Unison",      "Unison",    "", { 1.0, 8.0, 1.0, 1.0 }, 1.0, 0.0f);
-    voicesTrns = p.addExtParam (id + "unisontrns", nm + "Unison Trns", "LTrans",    "st", { -36.0, 36.0, 1.0, 1.0 }, 0.0, 0.0f);
-    tune       = p.addExtParam (id + "tune",       nm + "Tune",        "Tune",      "st", { -36.0, 36.0, 1.0, 1.0 }, 0.0, 0.0f);
-    finetune   = p.addExtParam (id + "finetune",   nm + "Fine Tune",   "Fine",      "ct", { -100.0, 100.0, 0.0, 1.0 }, 0.0, 0.0f);
-    level      = p.addExtParam (id + "level",      nm + "Level",       "Level",     "db", { -100.0, 0.0, 1.0, 4.0 }, 0.0, 0.0f);
-    pulsewidth = p.addExtParam (id + "pulsewidth", nm + "Pulse Width", "PW",        "%", { 1.0, 99.0, 0.0, 1.0 }, 50.0, 0.0f);
-    detune     = p.addExtParam (id + "detune",     nm + "Detune",      "Detune",    "", { 0.0, 0.5, 0.0, 1.0 }, 0.0, 0.0f);
-    spread     = p.addExtParam (id + "spread",     nm + "Spread",      "Spread",    "%", { -100.0, 100.0, 0.0, 1.0 }, 0.0, 0.0f);
-    pan        = p.addExtParam (id + "pan",        nm + "Pan",         "Pan",       "", { -1.0, 1.0, 0.0, 1.0 }, 0.0, 0.0f);
+        if (group.indexed)
+        {
+            id += juce::String (idx + 1);
+            nm += juce::String (idx + 1) + " ";
+        }
 
-    level->conversionFunction = [] (float in)   { return juce::Decibels::decibelsToGain (in); };
-}
+        auto add = [&] (const Def<T>& d, int step)
+        {
+            Info info;
+            info.def        = &d;
+            info.step       = step;
+            info.uid        = id + d.id;
+            info.name       = nm + d.name;
+            info.shortName  = d.shortName;
+            info.label      = d.label;
+
+            if (step >= 0)
+            {
+                info.uid  += juce::String (step + 1);
+                info.name += juce::String (step + 1);
+            }
+
+            auto end = d.end;
+            if (d.flags & beatRange)
+                end = float (gin::NoteDuration::getNoteDurations().size()) - 1.0f;
+            else if (d.flags & hzRange)
+                end = float (gin::getMidiNoteFromHertz (double (d.end)));
+
+            info.range = { d.start, end, d.interval, d.skew, (d.flags & symmetricSkew) != 0 };
+
+            if (d.flags & onForFirst)
+                info.defaultValue = idx == 0 ? 1.0f : 0.0f;
+            else if (d.flags & gatePattern)
+                info.defaultValue = (step % 2 == 0 || step % 5 == 0) ? 1.0f : 0.0f;
+            else if (d.flags & hzDefault)
+                info.defaultValue = float (gin::getMidiNoteFromHertz (double (d.defaultValue)));
+            else
+                info.defaultValue = d.defaultValue;
 
-//==============================================================================
-void VirtualAnalogAudioProcessor::FilterParams::setup (VirtualAnalogAudioProcessor& p, int idx)
-{
-    juce::String id = "flt" + juce::String (idx + 1);
-    juce::String nm = "FLT" + juce::String (idx + 1) + " ";
+            infos.push_back (info);
+        };
+
+        for (auto& d : defs)
+            if (d.steps == nullptr)
+                add (d, -1);
+
+        for (int step = 0; step < numSteps; step++)
+            for (auto& d : defs)
+                if (d.steps != nullptr)
+                    add (d, step);
+    }
+
+    for (auto& info : infos)
+    {
+        auto& d = *info.def;
 
-    float maxFreq = float (gin::getMidiNoteFromHertz (20000.0));
+        gin::Parameter::Ptr param;
 
-    enable           = p.addIntParam (id + "enable",  nm + "Enable",  "",      "", { 0.0, 1.0, 1.0, 1.0 }, idx == 0 ? 1.0f : 0.0f, 0.0f);
-    type             = p.addIntParam (id + "type",    nm + "Type",    "Type",  "", { 0.0, 7.0, 1.0, 1.0 }, 0.0, 0.0f, filterTextFunction);
-    keyTracking      = p.addExtParam (id + "key",     nm + "Key",     "Key",   "%", { 0.0, 100.0, 0.0, 1.0 }, 0.0, 0.0f);
-    velocityTracking = p.addExtParam (id + "vel",     nm + "Vel",     "Vel",   "%", { 0.0, 100.0, 0.0, 1.0 }, 0.0, 0.0f);
-    frequency        = p.addExtParam (id + "freq",    nm + "Freq",    "Freq",  "Hz", { 0.0, maxFreq, 0.0, 1.0 }, 64.0, 0.0f, freqTextFunction);
-    resonance        = p.addExtParam (id + "res",     nm + "Res",     "Res",   "", { 0.0, 100.0, 0.0, 1.0 }, 0.0, 0.0f);
-    amount           = p.addExtParam (id + "amount",  nm + "Amount",  "Amnt",  "", { -1.0, 1.0, 0.0, 1.0 }, 0.0, 0.0f);
-    attack           = p.addExtParam (id + "attack",  nm + "Attack",  "A",     "s", { 0.0, 60.0, 0.0, 0.2f }, 0.1f, 0.0f);
-    decay            = p.addExtParam (id + "decay",   nm + "Decay",   "D",     "s", { 0.0, 60.0, 0.0, 0.2f }, 0.1f, 0.0f);
-    sustain          = p.addExtParam (id + "sustain", nm + "Sustain", "S",     "%", { 0.0, 100.0, 0.0, 1.0 }, 80.0f, 0.0f);
-    release          = p.addExtParam (id + "release", nm + "Release", "R",     "s", { 0.0, 60.0, 0.0, 0.2f }, 0.1f, 0.0f);
+        if (d.flags & eased)
+            param = addIntParam (info.uid, info.name, info.shortName, info.label, info.range, info.defaultValue, { d.smoothing, gin::SmoothingType::eased }, d.text);
+        else if (d.flags & ext)
+            param = addExtParam (info.uid, info.name, info.shortName, info.label, info.range, info.defaultValue, d.smoothing, d.text);
+        else
+            param = addIntParam (info.uid, info.name, info.shortName, info.label, info.range, info.defaultValue, d.smoothing, d.text);
+
+        if (d.conversion != nullptr)
+            param->conversionFunction = d.conversion;
 
-    sustain->conversionFunction          = [] (float in) { return in / 100.0f; };
-    velocityTracking->conversionFunction = [] (float in) { return in / 100.0f; };
-    keyTracking->conversionFunction      = [] (float in) { return in / 100.0f; };
+        if (d.steps != nullptr)
+            (params.*(d.steps))[info.step] = param;
+        else
+            params.*(d.member) = param;
+    }
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::EnvParams::setup (VirtualAnalogAudioProcessor& p, int idx)
+using OSC   = VirtualAnalogAudioProcessor::OSCParams;
+using FLT   = VirtualAnalogAudioProcessor::FilterParams;
+using ENV   = VirtualAnalogAudioProcessor::EnvParams;
+using LFO   = VirtualAnalogAudioProcessor::LFOParams;
+using SLFO  = VirtualAnalogAudioProcessor::StepLFOParams;
+using GATE  = VirtualAnalogAudioProcessor::GateParams;
+using AMP   = VirtualAnalogAudioProcessor::ADSRParams;
+using GLB   = VirtualAnalogAudioProcessor::GlobalParams;
+using CHR   = VirtualAnalogAudioProcessor::ChorusParams;
+using DST   = VirtualAnalogAudioProcessor::DistortionParams;
+using EQ    = VirtualAnalogAudioProcessor::EQParams;
+using CMP   = VirtualAnalogAudioProcessor::CompressorParams;
+using DLY   = VirtualAnalogAudioProcessor::DelayParams;
+using RVB   = VirtualAnalogAudioProcessor::ReverbParams;
+using LIM   = VirtualAnalogAudioProcessor::LimiterParams;
+
+//==============================================================================
+static constexpr Group oscGroup { "osc", "OSC", true };
+
+static constexpr Def<OSC> oscDefs[] =
+{
+    { &OSC::enable,     "enable",     "Enable",      "Enable", "",   0.0f,    1.0f,   1.0f, 1.0f,  0.0f,  0.0f, onForFirst, nullptr, nullptr },
+    { &OSC::wave,       "wave",       "Wave",        "Wave",   "",   1.0f,    7.0f,   1.0f, 1.0f,  1.0f,  0.0f, 0,   waveTextFunction, nullptr },
+    { &OSC::voices,     "unison",     "Unison",      "Unison", "",   1.0f,    8.0f,   1.0f, 1.0f,  1.0f,  0.0f, 0,   nullptr, nullptr },
+    { &OSC::voicesTrns, "unisontrns", "Unison Trns", "LTrans", "st", -36.0f,  36.0f,  1.0f, 1.0f,  0.0f,  0.0f, ext, nullptr, nullptr },
+    { &OSC::tune,       "tune",       "Tune",        "Tune",   "st", -36.0f,  36.0f,  1.0f, 1.0f,  0.0f,  0.0f, ext, nullptr, nullptr },
+    { &OSC::finetune,   "finetune",   "Fine Tune",   "Fine",   "ct", -100.0f, 100.0f, 0.0f, 1.0f,  0.0f,  0.0f, ext, nullptr, nullptr },
+    { &OSC::level,      "level",      "Level",       "Level",  "db", -100.0f, 0.0f,   1.0f, 4.0f,  0.0f,  0.0f, ext, nullptr, dbToGain },
+    { &OSC::pulsewidth, "pulsewidth", "Pulse Width", "PW",     "%",  1.0f,    99.0f,  0.0f, 1.0f,  50.0f, 0.0f, ext, nullptr, nullptr },
+    { &OSC::detune,     "detune",     "Detune",      "Detune", "",   0.0f,    0.5f,   0.0f, 1.0f,  0.0f,  0.0f, ext, nullptr, nullptr },
+    { &OSC::spread,     "spread",     "Spread",      "Spread", "%",  -100.0f, 100.0f, 0.0f, 1.0f,  0.0f,  0.0f, ext, nullptr, nullptr },
+    { &OSC::pan,        "pan",        "Pan",         "Pan",    "",   -1.0f,   1.0f,   0.0f, 1.0f,  0.0f,  0.0f, ext, nullptr, nullptr },
+};
+
+// Added later, so they're registered after every other parameter to keep the
+// indices hosts have saved. A table other than off replaces the wave.
+static constexpr Group oscWavetableGroup { "osc", "OSC", true };
+
+static constexpr Def<OSC> oscWavetableDefs[] =
 {
-    juce::String id = "env" + juce::String (idx + 1);
-    juce::String nm = "ENV" + juce::String (idx + 1) + " ";
+    { &OSC::table,      "table",      "Table",       "Table",  "",   0.0f,    128.0f, 1.0f, 1.0f,  0.0f,  0.0f, 0,   wavetableTextFunction, nullptr },
+    { &OSC::frame,      "frame",      "Frame",       "Frame",  "%",  0.0f,    100.0f, 0.0f, 1.0f,  0.0f,  0.0f, ext, nullptr, percentToUnit },
+};
 
-    enable           = p.addIntParam (id + "enable",  nm + "Enable",  "Enable", "", { 0.0, 1.0, 1.0, 1.0 }, 0.0, 0.0f, enableTextFunction);
-    attack           = p.addExtParam (id + "attack",  nm + "Attack",  "A",     "s", { 0.0, 60.0, 0.0, 0.2f }, 0.1f, 0.0f);
-    decay            = p.addExtParam (id + "decay",   nm + "Decay",   "D",     "s", { 0.0, 60.0, 0.0, 0.2f }, 0.1f, 0.0f);
-    sustain          = p.addExtParam (id + "sustain", nm + "Sustain", "S",     "%", { 0.0, 100.0, 0.0, 1.0 }, 80.0f, 0.0f);
-    release          = p.addExtParam (id + "release", nm + "Release", "R",     "s", { 0.0, 60.0, 0.0, 0.2f }, 0.1f, 0.0f);
+void VirtualAnalogAudioProcessor::OSCParams::setup (VirtualAnalogAudioProcessor& p, int idx)
+{
+    p.addParams (*this, oscGroup, oscDefs, idx);
+}
 
-    sustain->conversionFunction = [] (float in) { return in / 100.0f; };
+void VirtualAnalogAudioProcessor::OSCParams::setupWavetable (VirtualAnalogAudioProcessor& p, int idx)
+{
+    p.addParams (*this, oscWavetableGroup, oscWavetableDefs, idx);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::LFOParams::setup (VirtualAnalogAudioProcessor& p, int idx)
-{
-    juce::String id = "lfo" + juce::String (idx + 1);
-    juce::String nm = "LFO" + juce::String (idx + 1) + " ";
+static constexpr Group filterGroup { "flt", "FLT", true };
 
-    auto notes = gin::NoteDuration::getNoteDurations();
+static constexpr Def<FLT> filterDefs[] =
+{
+    { &FLT::enable,           "enable",  "Enable",  "",     "",   0.0f,  1.0f,     1.0f, 1.0f,  0.0f,  0.0f, onForFirst,    nullptr, nullptr },
+    { &FLT::type,             "type",    "Type",    "Type", "",   0.0f,  7.0f,     1.0f, 1.0f,  0.0f,  0.0f, 0,             filterTextFunction, nullptr },
+    { &FLT::keyTracking,      "key",     "Key",     "Key",  "%",  0.0f,  100.0f,   0.0f, 1.0f,  0.0f,  0.0f, ext,           nullptr, percentToUnit },
+    { &FLT::velocityTracking, "vel",     "Vel",     "Vel",  "%",  0.0f,  100.0f,   0.0f, 1.0f,  0.0f,  0.0f, ext,           nullptr, percentToUnit },
+    { &FLT::frequency,        "freq",    "Freq",    "Freq", "Hz", 0.0f,  20000.0f, 0.0f, 1.0f,  64.0f, 0.0f, ext | hzRange, freqTextFunction, nullptr },
+    { &FLT::resonance,        "res",     "Res",     "Res",  "",   0.0f,  100.0f,   0.0f, 1.0f,  0.0f,  0.0f, ext,           nullptr, nullptr },
+    { &FLT::amount,           "amount",  "Amount",  "Amnt", "",   -1.0f, 1.0f,     0.0f, 1.0f,  0.0f,  0.0f, ext,           nullptr, nullptr },
+    { &FLT::attack,           "attack",  "Attack",  "A",    "s",  0.0f,  60.0f,    0.0f, 0.2f,  0.1f,  0.0f, ext,           nullptr, nullptr },
+    { &FLT::decay,            "decay",   "Decay",   "D",    "s",  0.0f,  60.0f,    0.0f, 0.2f,  0.1f,  0.0f, ext,           nullptr, nullptr },
+    { &FLT::sustain,          "sustain", "Sustain", "S",    "%",  0.0f,  100.0f,   0.0f, 1.0f,  80.0f, 0.0f, ext,           nullptr, percentToUnit },
+    { &FLT::release,          "release", "Release", "R",    "s",  0.0f,  60.0f,    0.0f, 0.2f,  0.1f,  0.0f, ext,           nullptr, nullptr },
+};
 
-    enable           = p.addIntParam (id + "enable",  nm + "Enable",  "Enable", "", { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
-    sync             = p.addIntParam (id + "sync",    nm + "Sync",    "Sync",   "", { 0.0, 1.0, 1.0, 1.0 }, 0.0, 0.0f, enableTextFunction);
-    wave             = p.addIntParam (id + "wave",    nm + "Wave",    "Wave",   "", { 1.0, 17.0, 1.0, 1.0 }, 1.0, 0.0f, lfoTextFunction);
-    rate             = p.addExtParam (id + "rate",    nm + "Rate",    "Rate",   "Hz", { 0.0, 50.0, 0.0, 0.3f }, 10.0, 0.0f);
-    beat             = p.addIntParam (id + "beat",    nm + "Beat",    "Beat",   "", { 0.0, float (notes.size() - 1), 1.0, 1.0 }, 13.0, 0.0f, durationTextFunction);
-    depth            = p.addExtParam (id + "depth",   nm + "Depth",   "Depth",  "", { -1.0, 1.0, 0.0, 1.0 }, 1.0, 0.0f);
-    phase            = p.addExtParam (id + "phase",   nm + "Phase",   "Phase",  "", { -1.0, 1.0, 0.0, 1.0 }, 0.0, 0.0f);
-    offset           = p.addExtParam (id + "offset",  nm + "Offset",  "Offset", "", { -1.0, 1.0, 0.0, 1.0 }, 0.0, 0.0f);
-    fade             = p.addExtParam (id + "fade",    nm + "Fade",    "Fade",   "s", { -60.0, 60.0, 0.0, 0.2f, true }, 0.1f, 0.0f);
-    delay            = p.addExtParam (id + "delay",   nm + "Delay",   "Delay",  "s", { 0.0, 60.0, 0.0, 0.2f }, 0.1f, 0.0f);
+void VirtualAnalogAudioProcessor::FilterParams::setup (VirtualAnalogAudioProcessor& p, int idx)
+{
+    p.addParams (*this, filterGroup, filterDefs, idx);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::StepLFOParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Group envGroup { "env", "ENV", true };
+
+static constexpr Def<ENV> envDefs[] =
 {
-    juce::String id = "slfo";
-    juce::String nm = "Step LFO";
+    { &ENV::enable,  "enable",  "Enable",  "Enable", "",  0.0f, 1.0f,   1.0f, 1.0f, 0.0f,  0.0f, 0,   enableTextFunction, nullptr },
+    { &ENV::attack,  "attack",  "Attack",  "A",      "s", 0.0f, 60.0f,  0.0f, 0.2f, 0.1f,  0.0f, ext, nullptr, nullptr },
+    { &ENV::decay,   "decay",   "Decay",   "D",      "s", 0.0f, 60.0f,  0.0f, 0.2f, 0.1f,  0.0f, ext, nullptr, nullptr },
+    { &ENV::sustain, "sustain", "Sustain", "S",      "%", 0.0f, 100.0f, 0.0f, 1.0f, 80.0f, 0.0f, ext, nullptr, percentToUnit },
+    { &ENV::release, "release", "Release", "R",      "s", 0.0f, 60.0f,  0.0f, 0.2f, 0.1f,  0.0f, ext, nullptr, nullptr },
+};
 
-    auto notes = gin::NoteDuration::getNoteDurations();
+void VirtualAnalogAudioProcessor::EnvParams::setup (VirtualAnalogAudioProcessor& p, int idx)
+{
+    p.addParams (*this, envGroup, envDefs, idx);
+}
 
-    enable           = p.addIntParam (id + "enable",  nm + "Enable",  "Enable", "", { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
-    beat             = p.addIntParam (id + "beat",    nm + "Beat",    "Beat",   "", { 0.0, float (notes.size() - 1), 1.0, 1.0 }, 13.0, 0.0f, durationTextFunction);
-    length           = p.addIntParam (id + "length",  nm + "Length",   "Length", "", { 2.0, 32.0, 1.0, 1.0f }, 8.0f, 0.0f);
+//==============================================================================
+static constexpr Group lfoGroup { "lfo", "LFO", true };
 
-    for (int i = 0; i < 32; i++)
-    {
-        auto num = juce::String (i + 1);
-        level[i]     = p.addIntParam (id + "step" + num,  nm + "Step " + num, "", "", { -1.0, 1.0, 0.0, 1.0f }, 0.0f, 0.0f);
-    }
+static constexpr Def<LFO> lfoDefs[] =
+{
+    { &LFO::enable, "enable", "Enable", "Enable", "",   0.0f,   1.0f,  1.0f, 1.0f, 0.0f,  0.0f, 0,                   enableTextFunction, nullptr },
+    { &LFO::sync,   "sync",   "Sync",   "Sync",   "",   0.0f,   1.0f,  1.0f, 1.0f, 0.0f,  0.0f, 0,                   enableTextFunction, nullptr },
+    { &LFO::wave,   "wave",   "Wave",   "Wave",   "",   1.0f,   17.0f, 1.0f, 1.0f, 1.0f,  0.0f, 0,                   lfoTextFunction, nullptr },
+    { &LFO::rate,   "rate",   "Rate",   "Rate",   "Hz", 0.0f,   50.0f, 0.0f, 0.3f, 10.0f, 0.0f, ext,                 nullptr, nullptr },
+    { &LFO::beat,   "beat",   "Beat",   "Beat",   "",   0.0f,   0.0f,  1.0f, 1.0f, 13.0f, 0.0f, beatRange,           durationTextFunction, nullptr },
+    { &LFO::depth,  "depth",  "Depth",  "Depth",  "",   -1.0f,  1.0f,  0.0f, 1.0f, 1.0f,  0.0f, ext,                 nullptr, nullptr },
+    { &LFO::phase,  "phase",  "Phase",  "Phase",  "",   -1.0f,  1.0f,  0.0f, 1.0f, 0.0f,  0.0f, ext,                 nullptr, nullptr },
+    { &LFO::offset, "offset", "Offset", "Offset", "",   -1.0f,  1.0f,  0.0f, 1.0f, 0.0f,  0.0f, ext,                 nullptr, nullptr },
+    { &LFO::fade,   "fade",   "Fade",   "Fade",   "s",  -60.0f, 60.0f, 0.0f, 0.2f, 0.1f,  0.0f, ext | symmetricSkew, nullptr, nullptr },
+    { &LFO::delay,  "delay",  "Delay",  "Delay",  "s",  0.0f,   60.0f, 0.0f, 0.2f, 0.1f,  0.0f, ext,                 nullptr, nullptr },
+};
+
+void VirtualAnalogAudioProcessor::LFOParams::setup (VirtualAnalogAudioProcessor& p, int idx)
+{
+    p.addParams (*this, lfoGroup, lfoDefs, idx);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::GateParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Group stepLfoGroup { "slfo", "Step LFO", false };
+
+static constexpr Def<SLFO> stepLfoDefs[] =
 {
-    juce::String id = "gate";
-    juce::String nm = "Gate";
+    { &SLFO::enable, "enable", "Enable", "Enable", "", 0.0f,  1.0f,  1.0f, 1.0f, 0.0f,  0.0f, 0,         enableTextFunction, nullptr },
+    { &SLFO::beat,   "beat",   "Beat",   "Beat",   "", 0.0f,  0.0f,  1.0f, 1.0f, 13.0f, 0.0f, beatRange, durationTextFunction, nullptr },
+    { &SLFO::length, "length", "Length", "Length", "", 2.0f,  32.0f, 1.0f, 1.0f, 8.0f,  0.0f, 0,         nullptr, nullptr },
+    { nullptr,       "step",   "Step ",  "",       "", -1.0f, 1.0f,  0.0f, 1.0f, 0.0f,  0.0f, 0,         nullptr, nullptr, &SLFO::level },
+};
+
+void VirtualAnalogAudioProcessor::StepLFOParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, stepLfoGroup, stepLfoDefs);
+}
 
-    auto notes = gin::NoteDuration::getNoteDurations();
+//==============================================================================
+static constexpr Group gateGroup { "gate", "Gate", false };
 
-    enable           = p.addIntParam (id + "enable",  nm + "Enable",  "Enable", "", { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
-    beat             = p.addIntParam (id + "beat",    nm + "Beat",    "Beat",   "", { 0.0, float (notes.size() - 1), 1.0, 1.0 }, 7.0, 0.0f, durationTextFunction);
-    length           = p.addIntParam (id + "length",  nm + "Length",  "Length", "", { 2.0, 32.0, 1.0, 1.0f }, 8.0f, 0.0f);
-    attack           = p.addExtParam (id + "attack",  nm + "Attack",  "A",     "s", { 0.0, 1.0, 0.0, 0.2f }, 0.1f, 0.0f);
-    release          = p.addExtParam (id + "release", nm + "Release", "R",     "s", { 0.0, 1.0, 0.0, 0.2f }, 0.1f, 0.0f);
+static constexpr Def<GATE> gateDefs[] =
+{
+    { &GATE::enable,  "enable",  "Enable",  "Enable", "",  0.0f, 1.0f,  1.0f, 1.0f, 0.0f, 0.0f, 0,           enableTextFunction, nullptr },
+    { &GATE::beat,    "beat",    "Beat",    "Beat",   "",  0.0f, 0.0f,  1.0f, 1.0f, 7.0f, 0.0f, beatRange,   durationTextFunction, nullptr },
+    { &GATE::length,  "length",  "Length",  "Length", "",  2.0f, 32.0f, 1.0f, 1.0f, 8.0f, 0.0f, 0,           nullptr, nullptr },
+    { &GATE::attack,  "attack",  "Attack",  "A",      "s", 0.0f, 1.0f,  0.0f, 0.2f, 0.1f, 0.0f, ext,         nullptr, nullptr },
+    { &GATE::release, "release", "Release", "R",      "s", 0.0f, 1.0f,  0.0f, 0.2f, 0.1f, 0.0f, ext,         nullptr, nullptr },
+    { nullptr,        "l",       "L ",      "",       "",  0.0f, 1.0f,  1.0f, 1.0f, 0.0f, 0.0f, gatePattern, nullptr, nullptr, &GATE::l },
+    { nullptr,        "r",       "R ",      "",       "",  0.0f, 1.0f,  1.0f, 1.0f, 0.0f, 0.0f, gatePattern, nullptr, nullptr, &GATE::r },
+};
 
-    for (int i = 0; i < 32; i++)
-    {
-        auto num = juce::String (i + 1);
-        l[i]     = p.addIntParam (id + "l" + num,  nm + "L " + num, "", "", { 0.0, 1.0, 1.0, 1.0f }, (i % 2 == 0 || i % 5 == 0) ? 1.0f : 0.0f, 0.0f);
-        r[i]     = p.addIntParam (id + "r" + num,  nm + "R " + num, "", "", { 0.0, 1.0, 1.0, 1.0f }, (i % 2 == 0 || i % 5 == 0) ? 1.0f : 0.0f, 0.0f);
-    }
+void VirtualAnalogAudioProcessor::GateParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, gateGroup, gateDefs);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::ADSRParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Group noGroup { "", "", false };
+
+static constexpr Def<AMP> adsrDefs[] =
 {
-    velocityTracking = p.addExtParam ("vel",     "Vel",     "Vel",   "", { 0.0, 100.0, 0.0, 1.0 }, 100.0, 0.0f);
-    attack           = p.addExtParam ("attack",  "Attack",  "A",     "s", { 0.0, 60.0, 0.0, 0.2f },  0.1f, 0.0f);
-    decay            = p.addExtParam ("decay",   "Decay",   "D",     "s", { 0.0, 60.0, 0.0, 0.2f },  0.1f, 0.0f);
-    sustain          = p.addExtParam ("sustain", "Sustain", "S",     "%", { 0.0, 100.0, 0.0, 1.0 }, 80.0f, 0.0f);
-    release          = p.addExtParam ("release", "Release", "R",     "s", { 0.0, 60.0, 0.0, 0.2f },  0.1f, 0.0f);
+    { &AMP::velocityTracking, "vel",     "Vel",     "Vel", "",  0.0f, 100.0f, 0.0f, 1.0f, 100.0f, 0.0f, ext, nullptr, percentToUnit },
+    { &AMP::attack,           "attack",  "Attack",  "A",   "s", 0.0f, 60.0f,  0.0f, 0.2f, 0.1f,   0.0f, ext, nullptr, nullptr },
+    { &AMP::decay,            "decay",   "Decay",   "D",   "s", 0.0f, 60.0f,  0.0f, 0.2f, 0.1f,   0.0f, ext, nullptr, nullptr },
+    { &AMP::sustain,          "sustain", "Sustain", "S",   "%", 0.0f, 100.0f, 0.0f, 1.0f, 80.0f,  0.0f, ext, nullptr, percentToUnit },
+    { &AMP::release,          "release", "Release", "R",   "s", 0.0f, 60.0f,  0.0f, 0.2f, 0.1f,   0.0f, ext, nullptr, nullptr },
+};
 
-    sustain->conversionFunction          = [] (float in) { return in / 100.0f; };
-    velocityTracking->conversionFunction = [] (float in) { return in / 100.0f; };
+void VirtualAnalogAudioProcessor::ADSRParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, noGroup, adsrDefs);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::GlobalParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Def<GLB> globalDefs[] =
 {
-    mono        = p.addIntParam ("mono",    "Mono",       "",      "",   { 0.0, 1.0, 0.0, 1.0 }, 0.0, 0.0f, enableTextFunction);
-    glideMode   = p.addIntParam ("gMode",   "Glide Mode", "Glide", "",   { 0.0, 2.0, 0.0, 1.0 }, 0.0f, 0.0f, glideModeTextFunction);
-    glideRate   = p.addExtParam ("gRate",   "Glide Rate", "Rate",  "s",   { 0.001f, 20.0, 0.0, 0.2f }, 0.3f, 0.0f);
-    legato      = p.addIntParam ("legato",  "Legato",     "",      "",   { 0.0, 1.0, 0.0, 1.0 }, 0.0, 0.0f, enableTextFunction);
-    level       = p.addExtParam ("level",   "Level",      "",      "db", { -100.0, 0.0, 1.0, 4.0f }, 0.0, 0.0f);
-    voices      = p.addIntParam ("voices",  "Voices",     "",      "",   { 2.0, 40.0, 1.0, 1.0 }, 40.0f, 0.0f);
-    mpe         = p.addIntParam ("mpe",     "MPE",        "",      "",   { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
+    { &GLB::mono,      "mono",   "Mono",       "",      "",   0.0f,    1.0f,  0.0f, 1.0f, 0.0f,  0.0f, 0,   enableTextFunction, nullptr },
+    { &GLB::glideMode, "gMode",  "Glide Mode", "Glide", "",   0.0f,    2.0f,  0.0f, 1.0f, 0.0f,  0.0f, 0,   glideModeTextFunction, nullptr },
+    { &GLB::glideRate, "gRate",  "Glide Rate", "Rate",  "s",  0.001f,  20.0f, 0.0f, 0.2f, 0.3f,  0.0f, ext, nullptr, nullptr },
+    { &GLB::legato,    "legato", "Legato",     "",      "",   0.0f,    1.0f,  0.0f, 1.0f, 0.0f,  0.0f, 0,   enableTextFunction, nullptr },
+    { &GLB::level,     "level",  "Level",      "",      "db", -100.0f, 0.0f,  1.0f, 4.0f, 0.0f,  0.0f, ext, nullptr, dbToGain },
+    { &GLB::voices,    "voices", "Voices",     "",      "",   2.0f,    40.0f, 1.0f, 1.0f, 40.0f, 0.0f, 0,   nullptr, nullptr },
+    { &GLB::mpe,       "mpe",    "MPE",        "",      "",   0.0f,    1.0f,  1.0f, 1.0f, 0.0f,  0.0f, 0,   enableTextFunction, nullptr },
+};
 
-    level->conversionFunction     = [] (float in) { return juce::Decibels::decibelsToGain (in); };
+void VirtualAnalogAudioProcessor::GlobalParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, noGroup, globalDefs);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::ChorusParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Def<CHR> chorusDefs[] =
 {
-    enable = p.addIntParam ("chEnable",    "Enable",  "",   "",   { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
-    delay  = p.addExtParam ("chDelay",     "Delay",   "",   "ms", {0.1f, 30.0f, 0.0f, 1.0f}, 1.0f, 0.0f);
-    depth  = p.addExtParam ("chDepth",     "Depth",   "",   "ms", {0.1f, 20.0f, 0.0f, 1.0f}, 1.0f, 0.0f);
-    rate   = p.addExtParam ("chSpeed",     "Speed",   "",   "Hz", {0.1f, 10.0f, 0.0f, 1.0f}, 3.0f, 0.0f);
-    width  = p.addExtParam ("chWidth",     "Width",   "",   "",   {0.0f, 1.0f,  0.0f, 1.0f}, 0.5f, 0.0f);
-    mix    = p.addExtParam ("chMix",       "Mix",     "",   "",   {0.0f, 1.0f,  0.0f, 1.0f}, 0.5f, 0.0f);
+    { &CHR::enable, "chEnable", "Enable", "", "",   0.0f, 1.0f,  1.0f, 1.0f, 0.0f, 0.0f, 0,   enableTextFunction, nullptr },
+    { &CHR::delay,  "chDelay",  "Delay",  "", "ms", 0.1f, 30.0f, 0.0f, 1.0f, 1.0f, 0.0f, ext, nullptr, msToSeconds },
+    { &CHR::depth,  "chDepth",  "Depth",  "", "ms", 0.1f, 20.0f, 0.0f, 1.0f, 1.0f, 0.0f, ext, nullptr, msToSeconds },
+    { &CHR::rate,   "chSpeed",  "Speed",  "", "Hz", 0.1f, 10.0f, 0.0f, 1.0f, 3.0f, 0.0f, ext, nullptr, nullptr },
+    { &CHR::width,  "chWidth",  "Width",  "", "",   0.0f, 1.0f,  0.0f, 1.0f, 0.5f, 0.0f, ext, nullptr, nullptr },
+    { &CHR::mix,    "chMix",    "Mix",    "", "",   0.0f, 1.0f,  0.0f, 1.0f, 0.5f, 0.0f, ext, nullptr, nullptr },
+};
 
-    delay->conversionFunction = [] (float in) { return in / 1000.0f; };
-    depth->conversionFunction = [] (float in) { return in / 1000.0f; };
+void VirtualAnalogAudioProcessor::ChorusParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, noGroup, chorusDefs);
 }
 
 //==============================================================================
+static constexpr Def<DST> distortionDefs[] =
+{
+    { &DST::enable,   "dsEnable",   "Enable",   "", "", 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0,   enableTextFunction, nullptr },
+    { &DST::amount,   "dsAmount",   "Amount",   "", "", 0.0f, 1.0f, 0.0f, 1.0f, 0.2f, 0.0f, ext, distortionAmountTextFunction, nullptr },
+    { &DST::highpass, "dsHighpass", "Highpass", "", "", 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, ext, nullptr, nullptr },
+    { &DST::output,   "dsOutput",   "Output",   "", "", 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, ext, nullptr, nullptr },
+    { &DST::mix,      "dsMix",      "Mix",      "", "", 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, ext, nullptr, nullptr },
+};
+
 void VirtualAnalogAudioProcessor::DistortionParams::setup (VirtualAnalogAudioProcessor& p)
 {
-    enable   = p.addIntParam ("dsEnable",   "Enable",     "",   "", { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
-    amount   = p.addExtParam ("dsAmount",   "Amount",     "",   "", { 0.0, 1.0, 0.0, 1.0 }, 0.2f, 0.0f, distortionAmountTextFunction);
-    highpass = p.addExtParam ("dsHighpass", "Highpass",   "",   "", { 0.0, 1.0, 0.0, 1.0 }, 0.0, 0.0f);
-    output   = p.addExtParam ("dsOutput",   "Output",     "",   "", { 0.0, 1.0, 0.0, 1.0 }, 1.0, 0.0f);
-    mix      = p.addExtParam ("dsMix",      "Mix",        "",   "", { 0.0, 1.0, 0.0, 1.0 }, 1.0, 0.0f);
+    p.addParams (*this, noGroup, distortionDefs);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::EQParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Def<EQ> eqDefs[] =
 {
-    float maxFreq = float (gin::getMidiNoteFromHertz (20000.0));
-    float d1 = float (gin::getMidiNoteFromHertz (80.0));
-    float d2 = float (gin::getMidiNoteFromHertz (3000.0));
-    float d3 = float (gin::getMidiNoteFromHertz (5000.0));
-    float d4 = float (gin::getMidiNoteFromHertz (17000.0));
+    { &EQ::enable,   "eqEnable", "Enable",     "",     "",   0.0f,   1.0f,     1.0f, 1.0f, 0.0f,     0.0f, 0,                       enableTextFunction, nullptr },
 
-    enable   = p.addIntParam ("eqEnable",    "Enable",      "",     "", { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
+    { &EQ::loFreq,   "eqLoFreq", "Lo Freq",    "Freq", "Hz", 0.0f,   20000.0f, 0.0f, 1.0f, 80.0f,    0.0f, ext | hzRange | hzDefault, freqTextFunction, noteToHz },
+    { &EQ::loQ,      "eqLoQ",    "Lo Q",       "Q",    "",   0.025f, 40.0f,    0.0f, 0.2f, 1.0f,     0.0f, ext,                     nullptr, nullptr },
+    { &EQ::loGain,   "eqLoGain", "Lo Gain",    "Gain", "dB", -20.0f, 20.0f,    0.0f, 1.0f, 0.0f,     0.0f, ext,                     nullptr, dbToGain },
 
-    loFreq   = p.addExtParam ("eqLoFreq",    "Lo Freq",     "Freq", "Hz", { 0.0, maxFreq, 0.0, 1.0 }, d1, 0.0f, freqTextFunction);
-    loQ      = p.addExtParam ("eqLoQ",       "Lo Q",        "Q",    "", { 0.025f, 40.0f, 0.0, 0.2f }, 1.0f, 0.0f);
-    loGain   = p.addExtParam ("eqLoGain",    "Lo Gain",     "Gain", "dB", { -20.0f, 20.0f, 0.0, 1.0 }, 0.0f, 0.0f);
+    { &EQ::mid1Freq, "eqM1Freq", "Min 1 Freq", "Freq", "Hz", 0.0f,   20000.0f, 0.0f, 1.0f, 3000.0f,  0.0f, ext | hzRange | hzDefault, freqTextFunction, noteToHz },
+    { &EQ::mid1Q,    "eqM1Q",    "Min 1 Q",    "Q",    "",   0.025f, 40.0f,    0.0f, 0.2f, 1.0f,     0.0f, ext,                     nullptr, nullptr },
+    { &EQ::mid1Gain, "eqM1Gain", "Min 1 Gain", "Gain", "dB", -20.0f, 20.0f,    0.0f, 1.0f, 0.0f,     0.0f, ext,                     nullptr, dbToGain },
 
-    mid1Freq = p.addExtParam ("eqM1Freq",    "Min 1 Freq",  "Freq", "Hz", { 0.0, maxFreq, 0.0, 1.0 }, d2, 0.0f, freqTextFunction);
-    mid1Q    = p.addExtParam ("eqM1Q",       "Min 1 Q",     "Q",    "", { 0.025f, 40.0f, 0.0, 0.2f }, 1.0f, 0.0f);
-    mid1Gain = p.addExtParam ("eqM1Gain",    "Min 1 Gain",  "Gain", "dB", { -20.0f, 20.0f, 0.0, 1.0 }, 0.0f, 0.0f);
+    { &EQ::mid2Freq, "eqM2Freq", "Mid 2 Freq", "Freq", "Hz", 0.0f,   20000.0f, 0.0f, 1.0f, 5000.0f,  0.0f, ext | hzRange | hzDefault, freqTextFunction, noteToHz },
+    { &EQ::mid2Q,    "eqM2Q",    "Mid 2 Q",    "Q",    "",   0.025f, 40.0f,    0.0f, 0.2f, 1.0f,     0.0f, ext,                     nullptr, nullptr },
+    { &EQ::mid2Gain, "eqM2Gain", "Mid 2 Gain", "Gain", "dB", -20.0f, 20.0f,    0.0f, 1.0f, 0.0f,     0.0f, ext,                     nullptr, dbToGain },
 
-    mid2Freq = p.addExtParam ("eqM2Freq",    "Mid 2 Freq",  "Freq", "Hz", { 0.0, maxFreq, 0.0, 1.0 }, d3, 0.0f, freqTextFunction);
-    mid2Q    = p.addExtParam ("eqM2Q",       "Mid 2 Q",     "Q",    "", { 0.025f, 40.0f, 0.0, 0.2f }, 1.0f, 0.0f);
-    mid2Gain = p.addExtParam ("eqM2Gain",    "Mid 2 Gain",  "Gain", "dB", { -20.0f, 20.0f, 0.0, 1.0 }, 0.0f, 0.0f);
+    { &EQ::hiFreq,   "eqHiFreq", "Hi Freq",    "Freq", "Hz", 0.0f,   20000.0f, 0.0f, 1.0f, 17000.0f, 0.0f, ext | hzRange | hzDefault, freqTextFunction, noteToHz },
+    { &EQ::hiQ,      "eqHiQ",    "Hi Q",       "Q",    "",   0.025f, 40.0f,    0.0f, 0.2f, 1.0f,     0.0f, ext,                     nullptr, nullptr },
+    { &EQ::hiGain,   "eqHiGain", "Hi Gain",    "Gain", "dB", -20.0f, 20.0f,    0.0f, 1.0f, 0.0f,     0.0f, ext,                     nullptr, dbToGain },
+};
 
-    hiFreq   = p.addExtParam ("eqHiFreq",    "Hi Freq",     "Freq", "Hz", { 0.0, maxFreq, 0.0, 1.0 }, d4, 0.0f, freqTextFunction);
-    hiQ      = p.addExtParam ("eqHiQ",       "Hi Q",        "Q",    "", { 0.025f, 40.0f, 0.0, 0.2f }, 1.0f, 0.0f);
-    hiGain   = p.addExtParam ("eqHiGain",    "Hi Gain",     "Gain", "dB", { -20.0f, 20.0f, 0.0, 1.0 }, 0.0f, 0.0f);
-
-    loFreq->conversionFunction   = [] (float in) { return gin::getMidiNoteInHertz (in); };
-    mid1Freq->conversionFunction = [] (float in) { return gin::getMidiNoteInHertz (in); };
-    mid2Freq->conversionFunction = [] (float in) { return gin::getMidiNoteInHertz (in); };
-    hiFreq->conversionFunction   = [] (float in) { return gin::getMidiNoteInHertz (in); };
-
-    loGain->conversionFunction   = [] (float in) { return juce::Decibels::decibelsToGain (in); };
-    mid1Gain->conversionFunction = [] (float in) { return juce::Decibels::decibelsToGain (in); };
-    mid2Gain->conversionFunction = [] (float in) { return juce::Decibels::decibelsToGain (in); };
-    hiGain->conversionFunction   = [] (float in) { return juce::Decibels::decibelsToGain (in); };
+void VirtualAnalogAudioProcessor::EQParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, noGroup, eqDefs);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::CompressorParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Def<CMP> compressorDefs[] =
 {
-    enable    = p.addIntParam ("cpEnable",    "Enable",    "", "",     { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
+    { &CMP::enable,    "cpEnable",    "Enable",  "", "",   0.0f,   1.0f,    1.0f, 1.0f, 0.0f,   0.0f, 0,   enableTextFunction, nullptr },
+    { &CMP::attack,    "cpAttack",    "Attack",  "", "ms", 1.0f,   200.0f,  0.0f, 0.4f, 1.0f,   0.1f, ext, nullptr, msToSeconds },
+    { &CMP::release,   "cpRelease",   "Release", "", "ms", 1.0f,   2000.0f, 0.0f, 0.4f, 5.0f,   0.1f, ext, nullptr, msToSeconds },
+    { &CMP::ratio,     "cpRatio",     "Ratio",   "", "",   1.0f,   30.0f,   0.0f, 0.4f, 5.0f,   0.1f, ext, nullptr, nullptr },
+    { &CMP::threshold, "cpThreshold", "Thresh",  "", "dB", -60.0f, 0.0f,    0.0f, 1.0f, -30.0f, 0.1f, ext, nullptr, nullptr },
+    { &CMP::gain,      "cpGain",      "Gain",    "", "dB", -30.0f, 30.0f,   0.0f, 1.0f, 0.0f,   0.1f, ext, nullptr, dbToGain },
+};
 
-    attack    = p.addExtParam ("cpAttack",    "Attack",    "", "ms",   { 1.0f,   200.0f, 0.0f, 0.4f},    1.0f, 0.1f);
-    release   = p.addExtParam ("cpRelease",   "Release",   "", "ms",   { 1.0f,  2000.0f, 0.0f, 0.4f},    5.0f, 0.1f);
-    ratio     = p.addExtParam ("cpRatio",     "Ratio",     "", "",     { 1.0f,    30.0f, 0.0f, 0.4f},    5.0f, 0.1f);
-    threshold = p.addExtParam ("cpThreshold", "Thresh",    "", "dB",     { -60.0f,   0.0f, 0.0f, 1.0f},  -30.0f, 0.1f);
-    gain      = p.addExtParam ("cpGain",      "Gain",      "", "dB",     { -30.0f,  30.0f, 0.0f, 1.0f},    0.0f, 0.1f);
-
-    attack->conversionFunction  = [] (float in) { return in / 1000.0f; };
-    release->conversionFunction = [] (float in) { return in / 1000.0f; };
-    gain->conversionFunction    = [] (float in) { return juce::Decibels::decibelsToGain (in); };
+void VirtualAnalogAudioProcessor::CompressorParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, noGroup, compressorDefs);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::DelayParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Def<DLY> delayDefs[] =
 {
-    enable = p.addIntParam ("dlEnable",    "Enable",     "",   "", { 0.0, 1.0, 1.0, 1.0 }, 0.0f, 0.0f, enableTextFunction);
-
-    float mxd = float (gin::NoteDuration::getNoteDurations().size()) - 1.0f;
+    { &DLY::enable, "dlEnable", "Enable", "", "",   0.0f,    1.0f,   1.0f, 1.0f, 0.0f,    0.0f, 0,               enableTextFunction, nullptr },
+    { &DLY::sync,   "dlSync",   "Sync",   "", "",   0.0f,    1.0f,   1.0f, 1.0f, 0.0f,    0.0f, ext,             enableTextFunction, nullptr },
+    { &DLY::time,   "dlTime",   "Delay",  "", "",   0.0f,    120.0f, 0.0f, 0.3f, 1.0f,    0.0f, ext,             nullptr, nullptr },
+    { &DLY::beat,   "dlBeat",   "Delay",  "", "",   0.0f,    0.0f,   1.0f, 1.0f, 13.0f,   0.0f, ext | beatRange, durationTextFunction, nullptr },
+    { &DLY::fb,     "dlFb",     "FB",     "", "dB", -100.0f, 0.0f,   0.0f, 5.0f, -10.0f,  0.1f, ext,             nullptr, dbToGain },
+    { &DLY::cf,     "dlCf",     "CF",     "", "dB", -100.0f, 0.0f,   0.0f, 5.0f, -100.0f, 0.1f, ext,             nullptr, dbToGain },
+    { &DLY::mix,    "dlMix",    "Mix",    "", "%",  0.0f,    100.0f, 0.0f, 1.0f, 0.5f,    0.1f, ext,             nullptr, percentToUnit },
+    { &DLY::delay,  "dlDelay",  "Delay",  "", "",   0.0f,    120.0f, 0.0f, 1.0f, 1.0f,    0.2f, eased,           nullptr, nullptr },
+};
 
-    sync  = p.addExtParam ("dlSync",  "Sync",      "", "",   {   0.0f,   1.0f, 1.0f, 1.0f},    0.0f, 0.0f, enableTextFunction);
-    time  = p.addExtParam ("dlTime",  "Delay",     "", "",   {   0.0f, 120.0f, 0.0f, 0.3f},    1.0f, 0.0f);
-    beat  = p.addExtParam ("dlBeat",  "Delay",     "", "",   {   0.0f,    mxd, 1.0f, 1.0f},   13.0f, 0.0f, durationTextFunction);
-    fb    = p.addExtParam ("dlFb",    "FB",        "", "dB", {-100.0f,   0.0f, 0.0f, 5.0f},  -10.0f, 0.1f);
-    cf    = p.addExtParam ("dlCf",    "CF",        "", "dB", {-100.0f,   0.0f, 0.0f, 5.0f}, -100.0f, 0.1f);
-    mix   = p.addExtParam ("dlMix",   "Mix",       "", "%",  {   0.0f, 100.0f, 0.0f, 1.0f},    0.5f, 0.1f);
-
-    delay = p.addIntParam ("dlDelay", "Delay",     "", "",   {   0.0f, 120.0f, 0.0f, 1.0f},    1.0f, {0.2f, gin::SmoothingType::eased});
-
-    fb->conversionFunction  = [] (float in) { return juce::Decibels::decibelsToGain (in); };
-    cf->conversionFunction  = [] (float in) { return juce::Decibels::decibelsToGain (in); };
-    mix->conversionFunction = [] (float in) { return in / 100.0f; };
+void VirtualAnalogAudioProcessor::DelayParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, noGroup, delayDefs);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::ReverbParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Def<RVB> reverbDefs[] =
 {
-    enable     = p.addIntParam ("rvEnable",   "Enable",  "",   "", { 0.0, 1.0, 1.0, 1.0 }, 0.0, 0.0f);
+    { &RVB::enable,     "rvEnable",   "Enable",  "", "", 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0,   nullptr, nullptr },
+    { &RVB::damping,    "rvbDamping", "Damping", "", "", 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, ext, nullptr, nullptr },
+    { &RVB::freezeMode, "rvbFreeze",  "Freeze",  "", "", 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, ext, nullptr, nullptr },
+    { &RVB::roomSize,   "rvbSize",    "Size",    "", "", 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, ext, nullptr, nullptr },
+    { &RVB::width,      "rvbWidth",   "Width",   "", "", 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, ext, nullptr, nullptr },
+    { &RVB::mix,        "rvbMix",     "Mix",     "", "", 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, ext, nullptr, nullptr },
+};
 
-    damping    = p.addExtParam ("rvbDamping", "Damping", "",   "", {0.0f, 1.0f,    0.0f, 1.0f}, 0.0f, 0.0f);
-    freezeMode = p.addExtParam ("rvbFreeze",  "Freeze",  "",   "", {0.0f, 1.0f,    0.0f, 1.0f}, 0.0f, 0.0f);
-    roomSize   = p.addExtParam ("rvbSize",    "Size",    "",   "", {0.0f, 1.0f,    0.0f, 1.0f}, 0.0f, 0.0f);
-    width      = p.addExtParam ("rvbWidth",   "Width",   "",   "", {0.0f, 1.0f,    0.0f, 1.0f}, 0.0f, 0.0f);
-    mix        = p.addExtParam ("rvbMix",     "Mix",     "",   "", {0.0f, 1.0f,    0.0f, 1.0f}, 0.0f, 0.0f);
+void VirtualAnalogAudioProcessor::ReverbParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, noGroup, reverbDefs);
 }
 
 //==============================================================================
-void VirtualAnalogAudioProcessor::LimiterParams::setup (VirtualAnalogAudioProcessor& p)
+static constexpr Def<LIM> limiterDefs[] =
 {
-    enable    = p.addIntParam ("lmEnable",    "Enable",    "", "",     { 0.0, 1.0, 1.0, 1.0 }, 0.0, 0.0f);
+    { &LIM::enable,    "lmEnable",    "Enable",  "", "",   0.0f,   1.0f,   1.0f, 1.0f, 0.0f,   0.0f, 0,   nullptr, nullptr },
+    { &LIM::attack,    "lmAttack",    "Attack",  "", "ms", 1.0f,   5.0f,   0.0f, 0.4f, 1.0f,   0.1f, ext, nullptr, msToSeconds },
+    { &LIM::release,   "lmRelease",   "Release", "", "ms", 1.0f,   100.0f, 0.0f, 0.4f, 5.0f,   0.1f, ext, nullptr, msToSeconds },
+    { &LIM::threshold, "lmThreshold", "Ceil",    "", "dB", -60.0f, 0.0f,   0.0f, 1.0f, -30.0f, 0.1f, ext, nullptr, nullptr },
+    { &LIM::gain,      "lmGain",      "Gain",    "", "dB", -30.0f, 30.0f,  0.0f, 1.0f, 0.0f,   0.1f, ext, nullptr, dbToGain },
+};
 
-    attack    = p.addExtParam ("lmAttack",    "Attack",    "", "ms",   { 1.0f,     5.0f, 0.0f, 0.4f},    1.0f, 0.1f);
-    release   = p.addExtParam ("lmRelease",   "Release",   "", "ms",   { 1.0f,   100.0f, 0.0f, 0.4f},    5.0f, 0.1f);
-    threshold = p.addExtParam ("lmThreshold", "Ceil",      "", "dB",   { -60.0f,   0.0f, 0.0f, 1.0f},  -30.0f, 0.1f);
-    gain      = p.addExtParam ("lmGain",      "Gain",      "", "dB",   { -30.0f,  30.0f, 0.0f, 1.0f},    0.0f, 0.1f);
-
-    attack->conversionFunction  = [] (float in) { return in / 1000.0f; };
-    release->conversionFunction = [] (float in) { return in / 1000.0f; };
-    gain->conversionFunction    = [] (float in) { return juce::Decibels::decibelsToGain (in); };
+void VirtualAnalogAudioProcessor::LimiterParams::setup (VirtualAnalogAudioProcessor& p)
+{
+    p.addParams (*this, noGroup, limiterDefs);
 }
 
 //==============================================================================
@@ -408,28 +560,52 @@ VirtualAnalogAudioProcessor::VirtualAnalogAudioProcessor()
     reverbParams.setup (*this);
     limiterParams.setup (*this);
 
+    for (int i = 0; i < juce::numElementsInArray (oscParams); i++)
+        oscParams[i].setupWavetable (*this, i);
+
     eq.setNumChannels (2);
     compressor.setNumChannels (2);
     limiter.setNumChannels (2);
 
-    for (int i = 0; i < 50; i++)
+    stepPatterns.setGateSteps (gateParams.l, gateParams.r);
+    stepPatterns.setLevelSteps (stepLfoParams.level);
+
+    voiceArena.create (maxVoices, *this);
+
+    for (int i = 0; i < voiceArena.size(); i++)
     {
-        auto voice = new VirtualAnalogVoice (*this, bandLimitedLookupTables);
+        auto voice = voiceArena.getVoice (i);
         modMatrix.addVoice (voice);
         addVoice (voice);
     }
 
+    voiceAllocator.setNumVoices (voices.size());
+
     setupModMatrix();
+
+    patchIndex->setDirectory (getProgramDirectory());
+    patchIndex->addChangeListener (&patchIndexListener);
+
+    updateProgramsFromIndex();
 }
 
 VirtualAnalogAudioProcessor::~VirtualAnalogAudioProcessor()
 {
+    patchIndex->removeChangeListener (&patchIndexListener);
+
+    // The voices belong to the arena, not the synth
+    voices.clear (false);
+    voiceArena.clear();
+
+    lookupTables = nullptr;
+    lookupTableCache->purge();
 }
 
 //==============================================================================
 void VirtualAnalogAudioProcessor::stateUpdated()
 {
     modMatrix.stateUpdated (state);
+    stepPatterns.markDirty();
 }
 
 void VirtualAnalogAudioProcessor::updateState()
@@ -437,6 +613,71 @@ void VirtualAnalogAudioProcessor::updateState()
     modMatrix.updateState (state);
 }
 
+void VirtualAnalogAudioProcessor::setCurrentProgram (int index)
+{
+    // Until now only its name and tags have been read, from the index
+    if (juce::isPositiveAndBelow (index, int (indexedPrograms.size())))
+    {
+        auto& ip = indexedPrograms[size_t (index)];
+        auto program = programs[index];
+
+        if (ip.file != juce::File() && program != nullptr && program->name == ip.name)
+            program->loadFromFile (ip.file);
+
+        ip.file = juce::File();
+    }
+
+    // The file has been read above, only applying it holds up the audio thread
+    patchSwitcher.switchPatch ([this, index] { gin::Processor::setCurrentProgram (index); });
+}
+
+void VirtualAnalogAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+    gin::Processor::changeProgramName (index, newName);
+    patchIndex->rescan();
+}
+
+void VirtualAnalogAudioProcessor::updateProgramsFromIndex()
+{
+    auto current = programs[getCurrentProgram()];
+    auto currentName = current != nullptr ? current->name : juce::String();
+
+    // The default program stays first
+    if (programs.size() > 1)
+        programs.removeRange (1, programs.size() - 1);
+
+    indexedPrograms.clear();
+    indexedPrograms.push_back ({});
+
+    currentProgram = 0;
+
+    for (auto& e : patchIndex->findByPrefix ({}))
+    {
+        auto p = programs.add (new gin::Program());
+        p->name   = e.name;
+        p->author = e.author;
+        p->tags   = e.tags;
+
+        indexedPrograms.push_back ({ e.name, e.file });
+
+        if (currentProgram == 0 && e.name == currentName)
+            currentProgram = programs.size() - 1;
+    }
+
+    updateHostDisplay();
+    sendChangeMessage();
+}
+
+void VirtualAnalogAudioProcessor::PatchIndexListener::changeListenerCallback (juce::ChangeBroadcaster*)
+{
+    proc.updateProgramsFromIndex();
+}
+
+void VirtualAnalogAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    patchSwitcher.switchPatch ([&] { gin::Processor::setStateInformation (data, sizeInBytes); });
+}
+
 //==============================================================================
 void VirtualAnalogAudioProcessor::setupModMatrix()
 {
@@ -473,11 +714,14 @@ void VirtualAnalogAudioProcessor::setupModMatrix()
         modSrcEnv.add (modMatrix.addPolyModSource (juce::String::formatted ("env%d", i + 1), juce::String::formatted ("Envelope %d", i + 1), false));
 
     auto firstMonoParam = globalParams.mono;
+    auto firstWavetableParam = oscParams[0].table;
     bool polyParam = true;
     for (auto pp : getPluginParameters())
     {
         if (pp == firstMonoParam)
             polyParam = false;
+        else if (pp == firstWavetableParam)
+            polyParam = true;
 
         if (! pp->isInternal())
         {
@@ -492,7 +736,12 @@ void VirtualAnalogAudioProcessor::reset()
 {
     Processor::reset();
 
+    for (auto v : voices)
+        if (auto vav = dynamic_cast<VirtualAnalogVoice*> (v))
+            vav->resetSeed();
+
     gate.reset();
+    appliedGate = {};
     chorus.reset();
     distortion.reset();
     stereoDelay.reset();
@@ -507,13 +756,28 @@ void VirtualAnalogAudioProcessor::reset()
         l.reset();
 
     modStepLFO.reset();
+    stepLfoLength = -1;
 }
 
 void VirtualAnalogAudioProcessor::prepareToPlay (double newSampleRate, int newSamplesPerBlock)
 {
     Processor::prepareToPlay (newSampleRate, newSamplesPerBlock);
 
-    bandLimitedLookupTables.setSampleRate (newSampleRate);
+    auto newTables = lookupTableCache->get (newSampleRate);
+    newTables->waitUntilReady();
+    wavetableBank->waitUntilLoaded();
+
+    if (newTables != lookupTables)
+    {
+        lookupTables = newTables;
+
+        for (auto v : voices)
+            if (auto vav = dynamic_cast<VirtualAnalogVoice*> (v))
+                vav->setLookupTables (lookupTables->get());
+
+        lookupTableCache->purge();
+    }
+
     setCurrentPlaybackSampleRate (newSampleRate);
 
     modMatrix.setSampleRate (newSampleRate);
@@ -533,20 +797,108 @@ void VirtualAnalogAudioProcessor::prepareToPlay (double newSampleRate, int newSa
         l.setSampleRate (newSampleRate);
 
     modStepLFO.setSampleRate (newSampleRate);
+
+    patchSwitcher.prepare (newSampleRate);
+
+    renderingVoices.ensureStorageAllocated (voices.size());
+    voiceBuffers.resize (size_t (voices.size()));
+    for (auto& b : voiceBuffers)
+        b.setSize (2, QualityGovernor::maxControlBlock);
+    voicesStillActive.resize (size_t (voices.size()));
+
+    qualityGovernor.prepare (newSampleRate, *globalSettings);
+
+    multirateVoices = globalSettings->getBool ("multirateVoices", false);
+
+    mpeMessageTiming = globalSettings->getBool ("mpeMessageTiming", false);
+    mpeSmoothing = globalSettings->getInt ("mpeSmoothingMs", 5) / 1000.0;
+    setMinimumRenderingSubdivisionSize (mpeMessageTiming ? 1 : maxSubBlock, false);
+
+    memoryLock.unlockAll();
+
+    if (globalSettings->getBool ("lockMemory", false))
+        lockMemory();
+}
+
+void VirtualAnalogAudioProcessor::lockMemory()
+{
+    memoryLock.lock (this, sizeof (*this));
+
+    memoryLock.lock (voiceArena.getVoiceData(), voiceArena.getVoiceDataSize());
+    memoryLock.lock (voiceArena.getHotData(), voiceArena.getHotDataSize());
+
+    for (auto& b : voiceBuffers)
+        for (int ch = 0; ch < b.getNumChannels(); ch++)
+            memoryLock.lock (b.getReadPointer (ch), size_t (b.getNumSamples()) * sizeof (float));
+
+    // Voices render into their own scratch, on whichever thread runs them
+    for (auto v : voices)
+    {
+        if (auto vav = dynamic_cast<VirtualAnalogVoice*> (v))
+        {
+            auto& b = vav->getScratchStorage();
+            for (int ch = 0; ch < b.getNumChannels(); ch++)
+                memoryLock.lock (b.getReadPointer (ch), size_t (b.getNumSamples()) * sizeof (float));
+        }
+    }
+
+    memoryLock.lock (renderingVoices.begin(), size_t (voices.size()) * sizeof (VirtualAnalogVoice*));
+    memoryLock.lock (voicesStillActive.data(), voicesStillActive.size());
+
+    prefaultEffects();
+
+    auto shared = lookupTables->get().lockMemory() + wavetableBank->lockMemory();
+    auto total = memoryLock.getLockedBytes() + shared;
+
+    auto message = "Locked " + juce::File::descriptionOfSizeInBytes (juce::int64 (total));
+    if (auto failed = memoryLock.getFailedBytes())
+        message << ", couldn't lock " << juce::File::descriptionOfSizeInBytes (juce::int64 (failed));
+
+    juce::Logger::writeToLog (message);
+}
+
+void VirtualAnalogAudioProcessor::prefaultEffects()
+{
+    // The effects keep their delay lines to themselves, so write every sample
+    // of them once by running their longest delay of silence through, then
+    // clear them again
+    juce::AudioSampleBuffer silence (2, 4096);
+
+    auto run = [&] (double seconds, auto process)
+    {
+        auto todo = int (std::ceil (seconds * getSampleRate())) + silence.getNumSamples();
+
+        for (; todo > 0; todo -= silence.getNumSamples())
+        {
+            silence.clear();
+            process();
+        }
+    };
+
+    run (maxChorusDelay, [&] { chorus.process (silence); });
+    run (maxStereoDelay, [&] { stereoDelay.process (silence); });
+    run (maxReverbDelay, [&] { reverb.processStereo (silence.getWritePointer (0), silence.getWritePointer (1), silence.getNumSamples()); });
+
+    chorus.reset();
+    stereoDelay.reset();
+    reverb.reset();
 }
 
 void VirtualAnalogAudioProcessor::releaseResources()
 {
+    memoryLock.unlockAll();
 }
 
 void VirtualAnalogAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
 {
     juce::ScopedNoDenormals noDenormals;
 
+    qualityGovernor.blockStarted();
+
     startBlock();
     setMPE (globalParams.mpe->isOn());
 
-    playhead = getPlayHead();
+    updateSyncedRates();
 
     int pos = 0;
     int todo = buffer.getNumSamples();
@@ -560,9 +912,13 @@ void VirtualAnalogAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     setGlideRate (globalParams.glideRate->getProcValue());
     setNumVoices (int (globalParams.voices->getProcValue()));
 
+    // Modulation is updated every maxSubBlock samples, less often if the
+    // quality governor has relaxed the control rate
+    auto controlBlock = qualityGovernor.getCurrentLevel().controlBlock;
+
     while (todo > 0)
     {
-        int thisBlock = std::min (todo, 32);
+        int thisBlock = std::min (todo, controlBlock);
 
         updateParams (thisBlock);
 
@@ -579,25 +935,97 @@ void VirtualAnalogAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
 
     playHead = nullptr;
 
+    updateLiveCutoffs();
+
+    patchSwitcher.process (buffer);
+
     fifo.write (buffer);
     endBlock (buffer.getNumSamples());
+
+    qualityGovernor.blockFinished (buffer.getNumSamples());
 }
 
-juce::Array<float> VirtualAnalogAudioProcessor::getLiveFilterCutoff (int i)
+void VirtualAnalogAudioProcessor::renderNextSubBlock (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
 {
-    juce::Array<float> values;
+    const juce::ScopedLock sl (voicesLock);
 
+    renderingVoices.clearQuick();
     for (auto v : voices)
-    {
         if (v->isActive())
-        {
-            auto vav = dynamic_cast<VirtualAnalogVoice*>(v);
-            values.add (vav->getFilterCutoffNormalized (i));
-        }
+            renderingVoices.add (dynamic_cast<VirtualAnalogVoice*> (v));
+
+    if (renderingVoices.size() < minParallelVoices || workerPool->getNumThreads() == 0
+        || numSamples > QualityGovernor::maxControlBlock || size_t (renderingVoices.size()) > voiceBuffers.size())
+    {
+        gin::Synthesiser::renderNextSubBlock (outputAudio, startSample, numSamples);
+        return;
+    }
+
+    // Each voice renders into its own buffer on whichever thread picks it up.
+    // Voices only write their own poly values in the mod matrix. Mono values
+    // are set on the audio thread before and after this, never during it.
+    workerPool->parallelFor (renderingVoices.size(), [&] (int i)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        auto& b = voiceBuffers[size_t (i)];
+        b.clear (0, numSamples);
+        voicesStillActive[size_t (i)] = renderingVoices[i]->renderVoice (b, 0, numSamples);
+    });
+
+    for (int i = 0; i < renderingVoices.size(); i++)
+    {
+        auto& b = voiceBuffers[size_t (i)];
+        outputAudio.addFrom (0, startSample, b, 0, 0, numSamples);
+        outputAudio.addFrom (1, startSample, b, 1, 0, numSamples);
+
+        renderingVoices[i]->finishRender (voicesStillActive[size_t (i)] != 0, numSamples);
     }
+}
+
+juce::Array<float> VirtualAnalogAudioProcessor::getLiveFilterCutoff (int i)
+{
+    juce::Array<float> values;
+
+    auto num = numLiveCutoffs.load();
+    for (int j = 0; j < num; j++)
+        values.add (liveCutoffs[i][j].load());
+
     return values;
 }
 
+void VirtualAnalogAudioProcessor::updateLiveCutoffs()
+{
+    auto active = voiceAllocator.getActiveVoices();
+    auto num    = voiceAllocator.getNumActive();
+
+    for (int j = 0; j < num; j++)
+        if (auto vav = dynamic_cast<VirtualAnalogVoice*> (voices[active[j]]))
+            for (int i = 0; i < Cfg::numFilters; i++)
+                liveCutoffs[i][j] = vav->getFilterCutoffNormalized (i);
+
+    numLiveCutoffs = num;
+}
+
+juce::MPESynthesiserVoice* VirtualAnalogAudioProcessor::findFreeVoice (juce::MPENote note, bool stealIfNoneAvailable) const
+{
+    auto free = voiceAllocator.getFreeVoice();
+
+    if (free >= 0 && voiceAllocator.getNumActive() < int (globalParams.voices->getProcValue()))
+        return voices[free];
+
+    if (stealIfNoneAvailable)
+        return findVoiceToSteal (note);
+
+    return nullptr;
+}
+
+juce::MPESynthesiserVoice* VirtualAnalogAudioProcessor::findVoiceToSteal (juce::MPENote note) const
+{
+    auto idx = voiceAllocator.getVoiceToSteal (note.isValid() ? note.initialNote : -1);
+    return idx >= 0 ? voices[idx] : nullptr;
+}
+
 void VirtualAnalogAudioProcessor::applyEffects (juce::AudioSampleBuffer& buffer)
 {
     // Apply gate
@@ -636,8 +1064,26 @@ void VirtualAnalogAudioProcessor::applyEffects (juce::AudioSampleBuffer& buffer)
     outputGain.process (buffer);
 }
 
+void VirtualAnalogAudioProcessor::updateSyncedRates()
+{
+    auto playhead = getPlayHead();
+
+    auto freq = [&] (gin::Parameter::Ptr beat)
+    {
+        return 1.0f / gin::NoteDuration::getNoteDurations()[size_t (beat->getProcValue())].toSeconds (playhead);
+    };
+
+    for (int i = 0; i < Cfg::numLFOs; i++)
+        lfoSyncedFreq[i] = freq (lfoParams[i].beat);
+
+    stepLfoSyncedFreq = freq (stepLfoParams.beat);
+    gateSyncedFreq    = freq (gateParams.beat);
+}
+
 void VirtualAnalogAudioProcessor::updateParams (int newBlockSize)
 {
+    stepPatterns.update();
+
     // Update Mono LFOs
     for (int i = 0; i < Cfg::numLFOs; i++)
     {
@@ -647,7 +1093,7 @@ void VirtualAnalogAudioProcessor::updateParams (int newBlockSize)
 
             float freq = 0;
             if (lfoParams[i].sync->getProcValue() > 0.0f)
-                freq = 1.0f / gin::NoteDuration::getNoteDurations()[size_t (lfoParams[i].beat->getProcValue())].toSeconds (playhead);
+                freq = lfoSyncedFreq[i];
             else
                 freq = modMatrix.getValue (lfoParams[i].rate);
 
@@ -673,14 +1119,10 @@ void VirtualAnalogAudioProcessor::updateParams (int newBlockSize)
     // Update Mono Step LFO
     if (stepLfoParams.enable->isOn())
     {
-        float freq = 1.0f / gin::NoteDuration::getNoteDurations()[size_t (stepLfoParams.beat->getProcValue())].toSeconds (playhead);
-
-        modStepLFO.setFreq (freq);
+        modStepLFO.setFreq (stepLfoSyncedFreq);
 
         int n = int (stepLfoParams.length->getProcValue());
-        modStepLFO.setNumPoints (n);
-        for (int i = n; --i >= 0;)
-            modStepLFO.setPoint (i, stepLfoParams.level[i]->getProcValue());
+        stepPatterns.applyTo (modStepLFO, n, stepLfoVersion, stepLfoLength);
 
         modStepLFO.process (newBlockSize);
 
@@ -694,16 +1136,12 @@ void VirtualAnalogAudioProcessor::updateParams (int newBlockSize)
     // Update Gate
     if (gateParams.enable->isOn())
     {
-        float freq = 1.0f / gin::NoteDuration::getNoteDurations()[size_t (gateParams.beat->getProcValue())].toSeconds (playhead);
-
         int n = int (gateParams.length->getProcValue());
 
         gate.setLength (n);
+        stepPatterns.applyTo (gate, n, appliedGate);
 
-        for (int i = 0; i < n; i++)
-            gate.setStep (i, gateParams.l[i]->isOn(), gateParams.r[i]->isOn());
-
-        gate.setFrequency (freq);
+        gate.setFrequency (gateSyncedFreq);
         gate.setAttack (modMatrix.getValue (gateParams.attack));
         gate.setRelease (modMatrix.getValue (gateParams.release));
     }
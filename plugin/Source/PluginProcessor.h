@@ -3,6 +3,18 @@
 #include <JuceHeader.h>
 
 #include "VirtualAnalogVoice.h"
+#include "LookupTableCache.h"
+#include "WavetableBank.h"
+#include "PatchSwitcher.h"
+#include "PatchIndex.h"
+#include "WorkerPool.h"
+#include "VoiceAllocator.h"
+#include "GlobalSettings.h"
+#include "MemoryLock.h"
+#include "VoiceArena.h"
+#include "ParamTable.h"
+#include "StepPatterns.h"
+#include "QualityGovernor.h"
 
 //==============================================================================
 class VirtualAnalogAudioProcessor : public gin::Processor,
@@ -16,6 +28,10 @@ public:
     void stateUpdated() override;
     void updateState() override;
 
+    void setCurrentProgram (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
     //==============================================================================
     void reset() override;
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
@@ -28,27 +44,47 @@ public:
     bool hasEditor() const override;
 
     void updateParams (int blockSize);
+    void updateSyncedRates();
     void setupModMatrix();
 
-    gin::BandLimitedLookupTables bandLimitedLookupTables;
+    template <typename T, size_t N>
+    void addParams (T& params, const ParamTable::Group& group, const ParamTable::Def<T> (&defs)[N], int idx = 0);
+
+    juce::SharedResourcePointer<LookupTableCache> lookupTableCache;
+    LookupTableCache::Tables::Ptr lookupTables;
+
+    juce::SharedResourcePointer<WavetableBank> wavetableBank;
 
     //==============================================================================
     void handleMidiEvent (const juce::MidiMessage& m) override;
     void handleController (int ch, int num, int val) override;
     //==============================================================================
+    /** The playing voices' cutoffs, as of the last block */
     juce::Array<float> getLiveFilterCutoff (int idx);
 
     void applyEffects (juce::AudioSampleBuffer& buffer);
 
+    /** Voices are rendered on the shared WorkerPool when enough are playing */
+    void renderNextSubBlock (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+
+    /** Voices come from voiceAllocator rather than a search of every voice */
+    juce::MPESynthesiserVoice* findFreeVoice (juce::MPENote note, bool stealIfNoneAvailable) const override;
+    juce::MPESynthesiserVoice* findVoiceToSteal (juce::MPENote note) const override;
+
+    static constexpr int maxVoices = 50;
+    static constexpr int maxSubBlock = 32;
+    static constexpr int minParallelVoices = 4;
+
     // Voice Params
     struct OSCParams
     {
         OSCParams() = default;
 
         gin::Parameter::Ptr enable , wave, voices, voicesTrns, tune, finetune,
-                            level, pulsewidth, detune, spread, pan;
+                            level, pulsewidth, detune, spread, pan, table, frame;
 
         void setup (VirtualAnalogAudioProcessor& p, int idx);
+        void setupWavetable (VirtualAnalogAudioProcessor& p, int idx);
 
         JUCE_DECLARE_NON_COPYABLE (OSCParams)
     };
@@ -243,11 +279,20 @@ public:
     ReverbParams reverbParams;
     LimiterParams limiterParams;
 
+    StepPatterns stepPatterns;
+
     //==============================================================================
     gin::GateEffect gate;
-    gin::Modulation chorus { 0.5f };
+    StepPatterns::AppliedGate appliedGate;
+    // Longest delays the effects hold, in seconds. juce::Reverb's longest comb
+    // is 1640 samples at 44.1 kHz.
+    static constexpr float maxChorusDelay = 0.5f;
+    static constexpr double maxStereoDelay = 120.1;
+    static constexpr double maxReverbDelay = 0.05;
+
+    gin::Modulation chorus { maxChorusDelay };
     gin::Distortion distortion;
-    gin::StereoDelay stereoDelay { 120.1 };
+    gin::StereoDelay stereoDelay { maxStereoDelay };
     gin::Dynamics compressor;
     gin::Dynamics limiter;
     gin::EQ eq {4};
@@ -260,8 +305,72 @@ public:
 
     gin::LFO modLFOs[Cfg::numLFOs];
     gin::StepLFO modStepLFO;
+    juce::uint32 stepLfoVersion = 0;
+    int stepLfoLength = -1;
+
+    // Tempo synced rates in Hz, from the host's playhead once a block on the
+    // audio thread, so voices rendering on the workers never read it
+    float lfoSyncedFreq[Cfg::numLFOs] = {};
+    float stepLfoSyncedFreq = 1.0f;
+    float gateSyncedFreq = 1.0f;
+
+    PatchSwitcher patchSwitcher { getCallbackLock() };
+
+    juce::SharedResourcePointer<PatchIndex> patchIndex;
+
+    // The program list is built from the patch index rather than by reading
+    // every patch, a program's file is only read when it's first loaded.
+    // Message thread.
+    void updateProgramsFromIndex();
+
+    struct IndexedProgram
+    {
+        juce::String name;
+        juce::File file;            // empty once loaded
+    };
+
+    std::vector<IndexedProgram> indexedPrograms;    // parallel to programs
+
+    /** Rebuilds the program list when the index changes */
+    struct PatchIndexListener : public juce::ChangeListener
+    {
+        PatchIndexListener (VirtualAnalogAudioProcessor& p) : proc (p) {}
+        void changeListenerCallback (juce::ChangeBroadcaster* source) override;
+
+        VirtualAnalogAudioProcessor& proc;
+    };
+
+    PatchIndexListener patchIndexListener { *this };
+
+    VoiceArena<VirtualAnalogVoice, VirtualAnalogVoice::HotState> voiceArena;
+    VoiceAllocator voiceAllocator;
+
+    juce::SharedResourcePointer<GlobalSettings> globalSettings;
+    MemoryLock memoryLock;
+
+    // MPE pressure and timbre are applied once a sub block and ramped over
+    // mpeSmoothing seconds, unless the mpeMessageTiming global setting asks
+    // for them as each message arrives
+    bool mpeMessageTiming = false;
+    double mpeSmoothing = 0.0;
+
+    QualityGovernor qualityGovernor;
+
+    // Voices with low cutoffs may run at a lower rate, see VirtualAnalogVoice::getAllowedRateFactor
+    bool multirateVoices = false;
+
+    void lockMemory();
+    void prefaultEffects();
+
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+    juce::Array<VirtualAnalogVoice*> renderingVoices;
+    std::vector<juce::AudioSampleBuffer> voiceBuffers;
+    std::vector<char> voicesStillActive;
 
-    juce::AudioPlayHead* playhead = nullptr;
+    // Copied out at the end of each block for the editor, which can't look at the voices
+    void updateLiveCutoffs();
+    std::atomic<float> liveCutoffs[Cfg::numFilters][maxVoices] = {};
+    std::atomic<int> numLiveCutoffs { 0 };
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VirtualAnalogAudioProcessor)
@@ -0,0 +1,108 @@
+#include "QualityGovernor.h"
+
+//==============================================================================
+static const QualityGovernor::Level qualityLevels[QualityGovernor::numLevels] =
+{
+    { 8,   32, "full quality" },
+    { 4,   32, "unison capped at 4 voices" },
+    { 2,   64, "unison capped at 2 voices, control rate halved" },
+    { 1,  128, "unison off, control rate quartered" },
+};
+
+// Time to let a step take effect before taking another
+static constexpr double settleSeconds = 0.05;
+
+// How quickly the load falls back after a slow block, rises are immediate
+static constexpr double loadReleaseSeconds = 0.3;
+
+QualityGovernor::~QualityGovernor()
+{
+    cancelPendingUpdate();
+}
+
+const QualityGovernor::Level& QualityGovernor::getLevelInfo (int l)
+{
+    return qualityLevels[juce::jlimit (0, numLevels - 1, l)];
+}
+
+void QualityGovernor::prepare (double newSampleRate, const GlobalSettings& settings)
+{
+    sampleRate     = newSampleRate;
+    enabled        = settings.getBool ("qualityGovernor", false);
+    highLoad       = settings.getInt ("qualityHighLoad", 80) / 100.0f;
+    lowLoad        = std::min (highLoad, settings.getInt ("qualityLowLoad", 50) / 100.0f);
+    recoverSeconds = settings.getInt ("qualityRecoverMs", 3000) / 1000.0;
+
+    level       = 0;
+    load        = 0.0f;
+    sinceChange = 0.0;
+    underLowFor = 0.0;
+}
+
+void QualityGovernor::blockStarted() noexcept
+{
+    if (enabled)
+        startTicks = juce::Time::getHighResolutionTicks();
+}
+
+void QualityGovernor::blockFinished (int numSamples) noexcept
+{
+    if (! enabled || numSamples <= 0)
+        return;
+
+    auto blockSeconds = numSamples / sampleRate;
+    auto usedSeconds  = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    auto thisLoad     = float (usedSeconds / blockSeconds);
+
+    auto l = load.load();
+    if (thisLoad > l)
+        l = thisLoad;
+    else
+        l += (thisLoad - l) * float (1.0 - std::exp (-blockSeconds / loadReleaseSeconds));
+    load = l;
+
+    sinceChange += blockSeconds;
+    underLowFor = l < lowLoad ? underLowFor + blockSeconds : 0.0;
+
+    if (l > highLoad && level < numLevels - 1 && sinceChange >= settleSeconds)
+        setLevel (level + 1);
+    else if (underLowFor >= recoverSeconds && level > 0)
+        setLevel (level - 1);
+}
+
+void QualityGovernor::setLevel (int newLevel) noexcept
+{
+    int start1, size1, start2, size2;
+    stepFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    if (size1 > 0)
+    {
+        steps[start1] = { level.load(), newLevel, load.load() };
+        stepFifo.finishedWrite (1);
+    }
+
+    level       = newLevel;
+    sinceChange = 0.0;
+    underLowFor = 0.0;
+
+    triggerAsyncUpdate();
+}
+
+void QualityGovernor::handleAsyncUpdate()
+{
+    int start1, size1, start2, size2;
+    stepFifo.prepareToRead (stepFifo.getNumReady(), start1, size1, start2, size2);
+
+    auto report = [this] (int start, int size)
+    {
+        for (int i = start; i < start + size; i++)
+            juce::Logger::writeToLog ("Quality " + juce::String (steps[i].to < steps[i].from ? "restored" : "reduced")
+                                      + " to level " + juce::String (steps[i].to) + ", " + getLevelInfo (steps[i].to).description
+                                      + " (load " + juce::String (juce::roundToInt (steps[i].load * 100.0f)) + "%)");
+    };
+
+    report (start1, size1);
+    report (start2, size2);
+
+    stepFifo.finishedRead (size1 + size2);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "GlobalSettings.h"
+
+//==============================================================================
+/** Trades a little fidelity for headroom when blocks start taking too long.
+
+    Time spent in each block is measured against how long the block lasts.
+    Once the load passes qualityHighLoad percent, the governor steps down a
+    level, capping unison and running the modulation at a slower control
+    rate. It only steps back up after the load has stayed under
+    qualityLowLoad percent for qualityRecoverMs, so it doesn't flap around
+    the limit. Off unless the qualityGovernor global setting is on.
+
+    Every step is written to the juce::Logger from the message thread.
+*/
+class QualityGovernor : private juce::AsyncUpdater
+{
+public:
+    struct Level
+    {
+        int maxUnison;
+        int controlBlock;           // samples between modulation updates
+        const char* description;
+    };
+
+    static constexpr int numLevels = 4;
+    static constexpr int maxControlBlock = 128;
+
+    QualityGovernor() = default;
+    ~QualityGovernor() override;
+
+    /** Reads the settings and goes back to full quality. Not from the audio thread. */
+    void prepare (double sampleRate, const GlobalSettings& settings);
+
+    /** Audio thread, around the work of each block */
+    void blockStarted() noexcept;
+    void blockFinished (int numSamples) noexcept;
+
+    int getLevel() const                    { return level; }
+    const Level& getCurrentLevel() const    { return getLevelInfo (level); }
+    float getLoad() const                   { return load; }
+
+    static const Level& getLevelInfo (int l);
+
+private:
+    void setLevel (int newLevel) noexcept;
+    void handleAsyncUpdate() override;
+
+    bool enabled = false;
+    double sampleRate = 44100.0;
+    float highLoad = 0.8f, lowLoad = 0.5f;
+    double recoverSeconds = 3.0;
+
+    // Audio thread only
+    juce::int64 startTicks = 0;
+    double sinceChange = 0.0, underLowFor = 0.0;
+
+    std::atomic<int> level { 0 };
+    std::atomic<float> load { 0.0f };
+
+    struct Step
+    {
+        int from, to;
+        float load;
+    };
+
+    juce::AbstractFifo stepFifo { 16 };
+    Step steps[16];
+
+    JUCE_DECLARE_NON_COPYABLE (QualityGovernor)
+};
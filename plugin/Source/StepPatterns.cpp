@@ -0,0 +1,99 @@
+#include "StepPatterns.h"
+
+//==============================================================================
+StepPatterns::~StepPatterns()
+{
+    for (int i = 0; i < numSteps; i++)
+    {
+        if (gateL != nullptr)       gateL[i]->removeListener (this);
+        if (gateR != nullptr)       gateR[i]->removeListener (this);
+        if (levelParams != nullptr) levelParams[i]->removeListener (this);
+    }
+}
+
+void StepPatterns::setGateSteps (gin::Parameter::Ptr (&left)[numSteps], gin::Parameter::Ptr (&right)[numSteps])
+{
+    gateL = left;
+    gateR = right;
+
+    for (int i = 0; i < numSteps; i++)
+    {
+        gateL[i]->addListener (this);
+        gateR[i]->addListener (this);
+    }
+
+    dirty = true;
+}
+
+void StepPatterns::setLevelSteps (gin::Parameter::Ptr (&params)[numSteps])
+{
+    levelParams = params;
+
+    for (int i = 0; i < numSteps; i++)
+        levelParams[i]->addListener (this);
+
+    dirty = true;
+}
+
+void StepPatterns::update()
+{
+    if (! dirty.exchange (false))
+        return;
+
+    if (gateL != nullptr && gateR != nullptr)
+    {
+        juce::uint32 l = 0, r = 0;
+        for (int i = 0; i < numSteps; i++)
+        {
+            if (gateL[i]->isOn()) l |= 1u << i;
+            if (gateR[i]->isOn()) r |= 1u << i;
+        }
+
+        gateLeft  = l;
+        gateRight = r;
+    }
+
+    if (levelParams != nullptr)
+    {
+        bool changed = false;
+        for (int i = 0; i < numSteps; i++)
+        {
+            auto v = levelParams[i]->getProcValue();
+            changed = changed || v != levels[i];
+            levels[i] = v;
+        }
+
+        if (changed)
+            levelsVersion++;
+    }
+}
+
+void StepPatterns::applyTo (gin::GateEffect& gate, int length, AppliedGate& applied) const
+{
+    auto mask = length >= numSteps ? ~0u : (1u << std::max (0, length)) - 1;
+
+    auto changed = ((gateLeft ^ applied.left) | (gateRight ^ applied.right) | ~applied.set) & mask;
+    if (changed == 0)
+        return;
+
+    for (int i = 0; changed != 0; i++, changed >>= 1)
+        if (changed & 1)
+            gate.setStep (i, (gateLeft >> i) & 1, (gateRight >> i) & 1);
+
+    applied.left  = (applied.left  & ~mask) | (gateLeft  & mask);
+    applied.right = (applied.right & ~mask) | (gateRight & mask);
+    applied.set  |= mask;
+}
+
+void StepPatterns::applyTo (gin::StepLFO& lfo, int length, juce::uint32& lastVersion, int& lastLength) const
+{
+    if (lastVersion == levelsVersion && lastLength == length)
+        return;
+
+    lfo.setNumPoints (length);
+    for (int i = length; --i >= 0;)
+        lfo.setPoint (i, levels[i]);
+
+    lastVersion = levelsVersion;
+    lastLength  = length;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParamTable.h"
+
+//==============================================================================
+/** The gate on/off steps and the step lfo levels, compiled into bit masks and
+    a table of levels when one of their parameters changes, rather than read
+    step by step every block.
+
+    update() runs on the audio thread and rebuilds only after a change, the
+    version goes up each time the levels are rebuilt so step lfos can tell
+    when their points are stale.
+*/
+class StepPatterns : private gin::Parameter::ParameterListener
+{
+public:
+    static constexpr int numSteps = ParamTable::numSteps;
+
+    StepPatterns() = default;
+    ~StepPatterns() override;
+
+    void setGateSteps (gin::Parameter::Ptr (&left)[numSteps], gin::Parameter::Ptr (&right)[numSteps]);
+    void setLevelSteps (gin::Parameter::Ptr (&levels)[numSteps]);
+
+    /** After a patch or state load, in case values were set quietly */
+    void markDirty()                        { dirty = true; }
+
+    void update();
+
+    juce::uint32 getGateLeft() const        { return gateLeft; }
+    juce::uint32 getGateRight() const       { return gateRight; }
+
+    const float* getLevels() const          { return levels; }
+    juce::uint32 getLevelsVersion() const   { return levelsVersion; }
+
+    /** What a gate was last given. Steps not in set have never been given a
+        value, reset it to have every step set again.
+    */
+    struct AppliedGate
+    {
+        juce::uint32 left = 0, right = 0, set = 0;
+    };
+
+    /** Sets only the steps of a gate that differ from what was last applied */
+    void applyTo (gin::GateEffect& gate, int length, AppliedGate& applied) const;
+
+    /** Sets the points of a step lfo if the levels or length have changed
+        since lastVersion and lastLength
+    */
+    void applyTo (gin::StepLFO& lfo, int length, juce::uint32& lastVersion, int& lastLength) const;
+
+private:
+    void valueUpdated (gin::Parameter*) override    { dirty = true; }
+
+    gin::Parameter::Ptr* gateL = nullptr;
+    gin::Parameter::Ptr* gateR = nullptr;
+    gin::Parameter::Ptr* levelParams = nullptr;
+
+    std::atomic<bool> dirty { true };
+
+    juce::uint32 gateLeft = 0, gateRight = 0;
+    float levels[numSteps] = {};
+    juce::uint32 levelsVersion = 1;
+
+    JUCE_DECLARE_NON_COPYABLE (StepPatterns)
+};
@@ -0,0 +1,134 @@
+#include "StereoSVF.h"
+
+//==============================================================================
+void StereoSVF::setSampleRate (double sr)
+{
+    sampleRate = sr;
+    piOverSampleRate = float (juce::MathConstants<double>::pi / sr);
+}
+
+void StereoSVF::reset()
+{
+    jassert (state != nullptr);
+
+    state->ic1eq = Vec4::expand (0.0f);
+    state->ic2eq = Vec4::expand (0.0f);
+
+    state->stage1[0] = state->stage1[1] = 0.0f;
+    state->a1Last = state->a2Last = state->a3Last = 0.0f;
+}
+
+void StereoSVF::process (juce::AudioSampleBuffer& buffer, const float* cutoff, float q)
+{
+    auto r = buffer.getNumChannels() > 1 ? buffer.getWritePointer (1) : nullptr;
+    process (buffer.getWritePointer (0), r, buffer.getNumSamples(), cutoff, q);
+}
+
+void StereoSVF::processRamp (juce::AudioSampleBuffer& buffer, float startHz, float endHz, float q)
+{
+    auto l = buffer.getWritePointer (0);
+    auto r = buffer.getNumChannels() > 1 ? buffer.getWritePointer (1) : nullptr;
+    auto numSamples = buffer.getNumSamples();
+
+    float cutoff[64];
+    auto step = (endHz - startHz) / float (std::max (1, numSamples));
+
+    for (int done = 0; done < numSamples; done += 64)
+    {
+        auto todo = std::min (64, numSamples - done);
+
+        for (int i = 0; i < todo; i++)
+            cutoff[i] = startHz + step * float (done + i + 1);
+
+        process (l + done, r != nullptr ? r + done : nullptr, todo, cutoff, q);
+    }
+}
+
+void StereoSVF::process (float* l, float* r, int numSamples, const float* cutoff, float q)
+{
+    if (numSamples <= 0)
+        return;
+
+    if (slope == db24)
+    {
+        if (r != nullptr)   processSamples<db24, true>  (l, r, numSamples, cutoff, q);
+        else                processSamples<db24, false> (l, r, numSamples, cutoff, q);
+    }
+    else
+    {
+        if (r != nullptr)   processSamples<db12, true>  (l, r, numSamples, cutoff, q);
+        else                processSamples<db12, false> (l, r, numSamples, cutoff, q);
+    }
+}
+
+template <StereoSVF::Slope slope, bool stereo>
+void StereoSVF::processSamples (float* l, float* r, int numSamples, const float* cutoff, float q)
+{
+    auto k = 1.0f / q;
+
+    // out = m0 * input + m1 * band + m2 * low
+    float m0 = 0.0f, m1 = 0.0f, m2 = 0.0f;
+    switch (type)
+    {
+        case lowpass:   m2 = 1.0f;                          break;
+        case highpass:  m0 = 1.0f; m1 = -k; m2 = -1.0f;     break;
+        case bandpass:  m1 = k;                             break;
+        case notch:     m0 = 1.0f; m1 = -k;                 break;
+    }
+
+    const auto mix0 = Vec4::expand (m0);
+    const auto mix1 = Vec4::expand (m1);
+    const auto mix2 = Vec4::expand (m2);
+
+    // Lanes are left and right of the first stage, then left and right of
+    // the second stage a sample behind, fed from the first stage's last output
+    constexpr int outLane = slope == db24 ? 2 : 0;
+
+    auto& s = *state;
+    auto ic1eq = s.ic1eq;
+    auto ic2eq = s.ic2eq;
+
+    auto out = Vec4::pair (s.stage1[0], s.stage1[1]);
+    auto A1  = Vec4::expand (s.a1Last);
+    auto A2  = Vec4::expand (s.a2Last);
+    auto A3  = Vec4::expand (s.a3Last);
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        auto g  = getG (cutoff[i]);
+        auto a1 = 1.0f / (1.0f + g * (g + k));
+        auto a2 = g * a1;
+        auto a3 = g * a2;
+
+        A1 = Vec4::lowHalves (Vec4::expand (a1), A1);
+        A2 = Vec4::lowHalves (Vec4::expand (a2), A2);
+        A3 = Vec4::lowHalves (Vec4::expand (a3), A3);
+
+        auto v0 = Vec4::lowHalves (Vec4::pair (l[i], stereo ? r[i] : l[i]), out);
+
+        auto v3 = v0 - ic2eq;
+        auto v1 = A1 * ic1eq + A2 * v3;
+        auto v2 = ic2eq + A2 * ic1eq + A3 * v3;
+
+        ic1eq = v1 + v1 - ic1eq;
+        ic2eq = v2 + v2 - ic2eq;
+
+        out = mix0 * v0 + mix1 * v1 + mix2 * v2;
+
+        l[i] = out.get<outLane>();
+        if constexpr (stereo)
+            r[i] = out.get<outLane + 1>();
+    }
+
+    s.ic1eq = ic1eq;
+    s.ic2eq = ic2eq;
+
+    s.stage1[0] = out.get<0>();
+    s.stage1[1] = out.get<1>();
+
+    s.a1Last = A1.get<0>();
+    s.a2Last = A2.get<0>();
+    s.a3Last = A3.get<0>();
+
+    frequency = cutoff[numSamples - 1];
+}
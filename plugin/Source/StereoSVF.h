@@ -0,0 +1,127 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Topology preserving state variable filter, with the same responses as
+    gin::Filter at a fixed cutoff but cheap enough to move the cutoff every
+    sample.
+
+    Left and right of both 12 dB stages run side by side in one four lane
+    register, kept in registers for the whole block. The second stage filters the first stage's output from the sample before,
+    so the 24 dB slopes are one sample late. A one channel buffer runs
+    through both sides, so the filter can move between mono and stereo
+    without a jump.
+*/
+class StereoSVF
+{
+public:
+    enum Type
+    {
+        lowpass,
+        highpass,
+        bandpass,
+        notch,
+    };
+
+    enum Slope
+    {
+        db12,
+        db24,
+    };
+
+    /** Four floats in one register, SIMDRegister is eight wide on AVX */
+    struct Vec4
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        __m128 v;
+
+        static Vec4 expand (float x) noexcept               { return { _mm_set1_ps (x) }; }
+        static Vec4 pair (float x, float y) noexcept        { return { _mm_setr_ps (x, y, 0.0f, 0.0f) }; }
+        static Vec4 lowHalves (Vec4 a, Vec4 b) noexcept     { return { _mm_movelh_ps (a.v, b.v) }; }
+
+        template <int lane>
+        float get() const noexcept                          { return _mm_cvtss_f32 (_mm_shuffle_ps (v, v, _MM_SHUFFLE (lane, lane, lane, lane))); }
+
+        Vec4 operator+ (Vec4 o) const noexcept              { return { _mm_add_ps (v, o.v) }; }
+        Vec4 operator- (Vec4 o) const noexcept              { return { _mm_sub_ps (v, o.v) }; }
+        Vec4 operator* (Vec4 o) const noexcept              { return { _mm_mul_ps (v, o.v) }; }
+       #elif JUCE_USE_ARM_NEON
+        float32x4_t v;
+
+        static Vec4 expand (float x) noexcept               { return { vdupq_n_f32 (x) }; }
+        static Vec4 pair (float x, float y) noexcept        { return { vcombine_f32 (vset_lane_f32 (y, vdup_n_f32 (x), 1), vdup_n_f32 (0.0f)) }; }
+        static Vec4 lowHalves (Vec4 a, Vec4 b) noexcept     { return { vcombine_f32 (vget_low_f32 (a.v), vget_low_f32 (b.v)) }; }
+
+        template <int lane>
+        float get() const noexcept                          { return vgetq_lane_f32 (v, lane); }
+
+        Vec4 operator+ (Vec4 o) const noexcept              { return { vaddq_f32 (v, o.v) }; }
+        Vec4 operator- (Vec4 o) const noexcept              { return { vsubq_f32 (v, o.v) }; }
+        Vec4 operator* (Vec4 o) const noexcept              { return { vmulq_f32 (v, o.v) }; }
+       #else
+        float v[4];
+
+        static Vec4 expand (float x) noexcept               { return { { x, x, x, x } }; }
+        static Vec4 pair (float x, float y) noexcept        { return { { x, y, 0.0f, 0.0f } }; }
+        static Vec4 lowHalves (Vec4 a, Vec4 b) noexcept     { return { { a.v[0], a.v[1], b.v[0], b.v[1] } }; }
+
+        template <int lane>
+        float get() const noexcept                          { return v[lane]; }
+
+        Vec4 operator+ (Vec4 o) const noexcept              { return { { v[0] + o.v[0], v[1] + o.v[1], v[2] + o.v[2], v[3] + o.v[3] } }; }
+        Vec4 operator- (Vec4 o) const noexcept              { return { { v[0] - o.v[0], v[1] - o.v[1], v[2] - o.v[2], v[3] - o.v[3] } }; }
+        Vec4 operator* (Vec4 o) const noexcept              { return { { v[0] * o.v[0], v[1] * o.v[1], v[2] * o.v[2], v[3] * o.v[3] } }; }
+       #endif
+    };
+
+    /** The integrators and pipeline, kept outside the filter so a voice can
+        pack it with the rest of its hot state. Set before use.
+    */
+    struct State
+    {
+        Vec4 ic1eq = Vec4::expand (0.0f), ic2eq = Vec4::expand (0.0f);
+        float stage1[2] = {};               // first stage output waiting for the second stage
+        float a1Last = 0.0f, a2Last = 0.0f, a3Last = 0.0f;
+    };
+
+    void setState (State& s)                { state = &s; }
+    void setSampleRate (double sr);
+    void setType (Type t)                   { type = t; }
+    void setSlope (Slope s)                 { slope = s; }
+    void reset();
+
+    /** Cutoff in Hz for each sample, q is held for the whole block */
+    void process (juce::AudioSampleBuffer& buffer, const float* cutoff, float q);
+
+    /** Moves the cutoff in a straight line from startHz to endHz over the block */
+    void processRamp (juce::AudioSampleBuffer& buffer, float startHz, float endHz, float q);
+
+    /** The cutoff of the last sample processed */
+    float getFrequency() const              { return frequency; }
+
+private:
+    /** tan (pi * f / sampleRate), with the cutoff kept to 0.45 of the sample
+        rate, where the approximation is within 5.2e-7 of std::tan
+    */
+    float getG (float hz) const noexcept
+    {
+        auto w = juce::jlimit (0.0f, 0.45f * juce::MathConstants<float>::pi, hz * piOverSampleRate);
+        return juce::dsp::FastMathApproximations::tan (w);
+    }
+
+    void process (float* l, float* r, int numSamples, const float* cutoff, float q);
+
+    /** The loop, with the slope and channel count fixed so it doesn't test them per sample */
+    template <Slope slope, bool stereo>
+    void processSamples (float* l, float* r, int numSamples, const float* cutoff, float q);
+
+    double sampleRate = 44100.0;
+    float piOverSampleRate = juce::MathConstants<float>::pi / 44100.0f;
+
+    Type type = lowpass;
+    Slope slope = db12;
+
+    State* state = nullptr;
+    float frequency = 1000.0f;
+};
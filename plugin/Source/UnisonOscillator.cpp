@@ -0,0 +1,183 @@
+#include "UnisonOscillator.h"
+
+//==============================================================================
+void UnisonOscillator::noteOn (juce::uint32 seed, float phase)
+{
+    jassert (state != nullptr);
+    state->noise.setSeed (seed);
+
+    for (auto& p : state->phases)
+        p = phase >= 0.0f ? phase : state->noise.nextFloat();
+}
+
+float UnisonOscillator::getDelta (float hz) const
+{
+    auto freq = std::min (float (sampleRate / 2.0), hz);
+    return float (freq / sampleRate);
+}
+
+void UnisonOscillator::updateTableOffset()
+{
+    tableNoteOffset = tables != nullptr ? float (12.0 * std::log2 (tables->getSampleRate() / sampleRate)) : 0.0f;
+}
+
+UnisonOscillator::Frames UnisonOscillator::getFrames (const Params& params, float delta) const
+{
+    Frames f;
+    if (wavetables == nullptr || ! juce::isPositiveAndBelow (params.table, wavetables->getNumTables()))
+        return f;
+
+    auto numFrames = wavetables->getNumFrames (params.table);
+    auto level     = WavetableBank::getLevel (delta);
+
+    auto pos = juce::jlimit (0.0f, 1.0f, params.frame) * float (numFrames - 1);
+    auto i   = std::min (int (pos), numFrames - 1);
+
+    f.a   = wavetables->getFrame (params.table, i, level);
+    f.b   = wavetables->getFrame (params.table, std::min (i + 1, numFrames - 1), level);
+    f.mix = pos - float (i);
+    return f;
+}
+
+void UnisonOscillator::processAdding (float note, const Params& params, juce::AudioSampleBuffer& buffer)
+{
+    jassert (tables != nullptr);
+
+    auto l = buffer.getWritePointer (0);
+    auto r = buffer.getNumChannels() > 1 ? buffer.getWritePointer (1) : nullptr;
+    auto numSamples = buffer.getNumSamples();
+
+    if (params.voices <= 1)
+    {
+        processVoiceAdding (state->phases[0], note, getDelta (FastMath::noteToHz (note)), params,
+                            params.gain * (1.0f - params.pan),
+                            params.gain * (1.0f + params.pan),
+                            l, r, numSamples);
+        return;
+    }
+
+    auto voices = std::min (params.voices, maxVoices);
+
+    auto baseNote   = note - params.detune / 2;
+    auto noteDelta  = params.detune / float (voices - 1);
+
+    auto basePan    = params.pan - params.spread;
+    auto panDelta   = (params.spread * 2) / float (voices - 1);
+
+    auto gain       = params.gain / std::sqrt (float (voices));
+
+    // Every voice's pitch in one go
+    float notes[maxVoices], hz[maxVoices];
+    for (int i = 0; i < voices; i++)
+        notes[i] = baseNote + noteDelta * float (i) + (i % 2 == 1 ? params.vcTrns : 0.0f);
+
+    FastMath::noteToHz (notes, hz, voices);
+
+    for (int i = 0; i < voices; i++)
+    {
+        auto pan = juce::jlimit (-1.0f, 1.0f, basePan + panDelta * float (i));
+
+        processVoiceAdding (state->phases[i], notes[i], getDelta (hz[i]), params, gain * (1.0f - pan), gain * (1.0f + pan), l, r, numSamples);
+    }
+}
+
+void UnisonOscillator::processVoiceAdding (float& phase, float note, float delta, const Params& params,
+                                           float leftGain, float rightGain, float* l, float* r, int numSamples)
+{
+    auto run = [&] (auto sample)
+    {
+        auto loop = [&] (auto stereo)
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                auto s = sample (phase);
+
+                l[i] += s * leftGain;
+                if constexpr (decltype (stereo)::value)
+                    r[i] += s * rightGain;
+
+                phase += delta;
+                if (phase >= 1.0f)
+                    phase -= 1.0f;
+            }
+        };
+
+        if (r != nullptr)
+            loop (std::true_type());
+        else
+            loop (std::false_type());
+    };
+
+    // Reads one table, float or 16 bit, interpolating in float either way
+    auto runTable = [&] (OscillatorTables::Wave w, float gain)
+    {
+        auto t = tables->getTable (w, note + tableNoteOffset, gain);
+
+        if (t.shorts != nullptr)
+            run ([t] (float p) { return OscillatorTables::lookup (t.shorts, p) * t.gain; });
+        else
+            run ([t] (float p) { return OscillatorTables::lookup (t.samples, p) * t.gain; });
+    };
+
+    // Difference of two band limited saws, offset by the pulse width
+    auto runPulse = [&] (float pw)
+    {
+        auto t  = tables->getTable (OscillatorTables::saw, note + tableNoteOffset);
+        auto dc = 2.0f * pw - 1.0f;
+
+        auto pulse = [pw, dc] (auto table, float gain)
+        {
+            return [table, gain, pw, dc] (float p)
+            {
+                auto p2 = p + 1.0f - pw;
+                if (p2 >= 1.0f)
+                    p2 -= 1.0f;
+
+                return (OscillatorTables::lookup (table, p2) - OscillatorTables::lookup (table, p)) * gain + dc;
+            };
+        };
+
+        if (t.shorts != nullptr)
+            run (pulse (t.shorts, t.gain));
+        else
+            run (pulse (t.samples, t.gain));
+    };
+
+    switch (params.wave)
+    {
+        case gin::Wave::silence:    break;
+        case gin::Wave::sine:       runTable (OscillatorTables::sine, 1.0f);        break;
+        case gin::Wave::triangle:   runTable (OscillatorTables::triangle, 1.0f);    break;
+        case gin::Wave::sawUp:      runTable (OscillatorTables::saw, 1.0f);         break;
+        case gin::Wave::sawDown:    runTable (OscillatorTables::saw, -1.0f);        break;
+        case gin::Wave::square:     runPulse (0.5f);                                break;
+        case gin::Wave::pulse:      runPulse (juce::jlimit (0.01f, 0.99f, params.pw)); break;
+        case gin::Wave::noise:
+        {
+            float block[64];
+            for (int done = 0; done < numSamples; done += 64)
+            {
+                auto todo = std::min (64, numSamples - done);
+                state->noise.fill (block, todo);
+
+                for (int i = 0; i < todo; i++)
+                {
+                    l[done + i] += block[i] * leftGain;
+                    if (r != nullptr)
+                        r[done + i] += block[i] * rightGain;
+                }
+            }
+            break;
+        }
+        case gin::Wave::wavetable:
+        {
+            auto frames = getFrames (params, delta);
+            if (frames.a != nullptr)
+                run ([frames] (float p) { return readFrames (frames, p); });
+            break;
+        }
+        default:
+            jassertfalse;
+            break;
+    }
+}
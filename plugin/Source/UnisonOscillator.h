@@ -0,0 +1,84 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OscillatorTables.h"
+#include "WavetableBank.h"
+#include "NoiseGenerator.h"
+#include "FastMath.h"
+
+//==============================================================================
+/** Stereo oscillator with up to 8 detuned unison voices, reading from
+    shared OscillatorTables or the WavetableBank. Given a one channel buffer,
+    only the left side is rendered, for when pan and spread are centred.
+*/
+class UnisonOscillator
+{
+public:
+    static constexpr int maxVoices = 8;
+
+    struct Params
+    {
+        gin::Wave wave = gin::Wave::sawUp;
+        int voices = 1;
+        float vcTrns = 0.0f;
+        float pw = 0.5f;
+        float pan = 0.0f;
+        float spread = 0.0f;
+        float detune = 0.0f;
+        float gain = 1.0f;
+        int table = 0;
+        float frame = 0.0f;
+    };
+
+    /** What changes every sample, kept outside the oscillator so a voice can
+        pack it with the rest of its hot state. Set before use.
+    */
+    struct State
+    {
+        float phases[maxVoices] = {};
+        NoiseGenerator noise;
+    };
+
+    void setState (State& s)                    { state = &s; }
+    void setTables (const OscillatorTables& t)  { tables = &t; updateTableOffset(); }
+    void setWavetables (const WavetableBank& w) { wavetables = &w; }
+    void setSampleRate (double sr)              { sampleRate = sr; updateTableOffset(); }
+
+    /** Seeds the noise and the random start phases, phase >= 0 starts every voice there instead */
+    void noteOn (juce::uint32 seed, float phase = -1.0f);
+
+    void processAdding (float note, const Params& params, juce::AudioSampleBuffer& buffer);
+
+private:
+    /** Two neighbouring wavetable frames and how far between them to read */
+    struct Frames
+    {
+        const float* a = nullptr;
+        const float* b = nullptr;
+        float mix = 0.0f;
+    };
+
+    /** Phase increment for a frequency, kept under nyquist */
+    float getDelta (float hz) const;
+    void updateTableOffset();
+    Frames getFrames (const Params& params, float delta) const;
+
+    static float readFrames (const Frames& f, float phase) noexcept
+    {
+        auto a = WavetableBank::lookup (f.a, phase);
+        return a + (WavetableBank::lookup (f.b, phase) - a) * f.mix;
+    }
+
+    void processVoiceAdding (float& phase, float note, float delta, const Params& params,
+                             float leftGain, float rightGain, float* l, float* r, int numSamples);
+
+    const OscillatorTables* tables = nullptr;
+    const WavetableBank* wavetables = nullptr;
+    double sampleRate = 44100.0;
+
+    // The tables are band limited for their own rate, a voice running slower
+    // has to pick a level as if the note were this much higher
+    float tableNoteOffset = 0.0f;
+
+    State* state = nullptr;
+};
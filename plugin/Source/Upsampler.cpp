@@ -0,0 +1,72 @@
+#include "Upsampler.h"
+
+//==============================================================================
+// Kaiser windowed halfband, odd taps from the outside in, already doubled
+// for the gain lost to the zeros between input samples
+static const float halfbandTaps[12] =
+{
+    -0.0014243472f,  0.0082261434f, -0.0272466062f,  0.0708078776f, -0.1727957992f,  0.6224327316f,
+     0.6224327316f, -0.1727957992f,  0.0708078776f, -0.0272466062f,  0.0082261434f, -0.0014243472f,
+};
+
+void Upsampler::setFactor (int f)
+{
+    jassert (f == 1 || f == 2 || f == 4);
+    factor = juce::jlimit (1, maxFactor, f);
+    reset();
+}
+
+void Upsampler::reset()
+{
+    for (auto& s : stages)
+        s.reset();
+}
+
+void Upsampler::process (const float* in, float* out, int numIn)
+{
+    if (factor == 1)
+    {
+        std::copy (in, in + numIn, out);
+    }
+    else if (factor == 2)
+    {
+        stages[0].process (in, out, numIn);
+    }
+    else
+    {
+        float tmp[128];
+        for (int done = 0; done < numIn; done += 64)
+        {
+            auto todo = std::min (64, numIn - done);
+
+            stages[0].process (in + done, tmp, todo);
+            stages[1].process (tmp, out + done * 4, todo * 2);
+        }
+    }
+}
+
+//==============================================================================
+void Upsampler::Stage::reset()
+{
+    std::fill (std::begin (history), std::end (history), 0.0f);
+    pos = 0;
+}
+
+void Upsampler::Stage::process (const float* in, float* out, int numIn)
+{
+    for (int i = 0; i < numIn; i++)
+    {
+        pos = (pos == 0 ? numTaps : pos) - 1;
+        history[pos] = history[pos + numTaps] = in[i];
+
+        // x[j] is the input from j samples ago
+        auto x = history + pos;
+
+        float odd = 0.0f;
+        for (int j = 0; j < numTaps; j++)
+            odd += halfbandTaps[j] * x[j];
+
+        out[2 * i]     = x[numTaps / 2];
+        out[2 * i + 1] = odd;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Raises one channel to 2x or 4x its sample rate with polyphase halfband
+    FIRs, one per doubling. Only the 12 tap odd phase is computed, even
+    outputs are the input delayed. The passband is flat to 0.3 of the input
+    rate and images of anything under 0.2 of it are 80 dB down, so it's
+    meant for signals already filtered well below their nyquist.
+
+    Each doubling delays the signal by 12 samples of its output rate.
+*/
+class Upsampler
+{
+public:
+    static constexpr int maxFactor = 4;
+    static constexpr int maxLatency = 36;
+
+    /** 1, 2 or 4. Resets the history. */
+    void setFactor (int f);
+    int getFactor() const                   { return factor; }
+
+    /** How far the output lags the input, in output samples */
+    int getLatency() const                  { return factor == 4 ? maxLatency : factor == 2 ? 12 : 0; }
+
+    void reset();
+
+    /** Writes numIn * getFactor() samples to out */
+    void process (const float* in, float* out, int numIn);
+
+private:
+    static constexpr int numTaps = 12;
+
+    struct Stage
+    {
+        void reset();
+        void process (const float* in, float* out, int numIn);
+
+        // Every sample is written twice so the taps can always be read in one run
+        float history[numTaps * 2] = {};
+        int pos = 0;
+    };
+
+    int factor = 1;
+    Stage stages[2];
+};
@@ -2,18 +2,52 @@
 #include "PluginProcessor.h"
 
 //==============================================================================
-VirtualAnalogVoice::VirtualAnalogVoice (VirtualAnalogAudioProcessor& p, gin::BandLimitedLookupTables& bllt)
-    : proc (p)
-    , bandLimitedLookupTables (bllt)
+VirtualAnalogVoice::VirtualAnalogVoice (VirtualAnalogAudioProcessor& p, int index_, HotState& hot_)
+    : proc (p), hot (hot_), index (index_)
 {
-    for (auto& f : filters)
-        f.setNumChannels (2);
+    for (int i = 0; i < Cfg::numOSCs; i++)
+    {
+        oscillators[i].setState (hot.oscillators[i]);
+        oscillators[i].setWavetables (proc.wavetableBank.getObject());
+    }
+
+    for (int i = 0; i < Cfg::numFilters; i++)
+        filters[i].setState (hot.filters[i]);
+
+    // Reduced rate voices render their upsampler's delay on top of the block
+    scratch.setSize (2 * numScratchUses, QualityGovernor::maxControlBlock + Upsampler::maxLatency + Upsampler::maxFactor);
+}
+
+juce::AudioSampleBuffer VirtualAnalogVoice::getScratch (ScratchUse use, int numChannels, int numSamples)
+{
+    jassert (numChannels <= 2 && numSamples <= scratch.getNumSamples());
+
+    float* chans[2] = { scratch.getWritePointer (2 * use), scratch.getWritePointer (2 * use + 1) };
+
+    juce::AudioSampleBuffer b (chans, numChannels, numSamples);
+    b.clear();
+    return b;
+}
+
+void VirtualAnalogVoice::setLookupTables (const OscillatorTables& tables)
+{
+    for (auto& osc : oscillators)
+        osc.setTables (tables);
+}
+
+void VirtualAnalogVoice::startOscillators()
+{
+    auto seed = juce::uint32 (index) * 0x9e3779b9u + ++noteCount * 0x85ebca6bu;
+
+    for (int i = 0; i < Cfg::numOSCs; i++)
+        oscillators[i].noteOn (seed + juce::uint32 (i));
 }
 
 void VirtualAnalogVoice::noteStarted()
 {
     fastKill = false;
     startVoice();
+    proc.voiceAllocator.voiceStarted (index, getCurrentlyPlayingNote().initialNote);
 
     auto note = getCurrentlyPlayingNote();
     if (glideInfo.fromNote != -1 && (glideInfo.glissando || glideInfo.portamento))
@@ -28,14 +62,17 @@ void VirtualAnalogVoice::noteStarted()
     }
 
     proc.modMatrix.setPolyValue (*this, proc.modSrcVelocity, note.noteOnVelocity.asUnsignedFloat());
-    proc.modMatrix.setPolyValue (*this, proc.modSrcTimbre, note.initialTimbre.asUnsignedFloat());
+    proc.modMatrix.setPolyValue (*this, proc.modSrcTimbre, note.timbre.asUnsignedFloat());
     proc.modMatrix.setPolyValue (*this, proc.modSrcPressure, note.pressure.asUnsignedFloat());
+    startExpression (note);
 
     juce::ScopedValueSetter<bool> svs (disableSmoothing, true);
 
     for (auto& f : filters)
         f.reset();
 
+    std::fill (std::begin (filterFade), std::end (filterFade), 0);
+
     for (auto& a : filterADSRs)
         a.reset();
 
@@ -49,9 +86,10 @@ void VirtualAnalogVoice::noteStarted()
     snapParams();
     updateParams (0);
     snapParams();
-    
-    for (auto& osc : oscillators)
-        osc.noteOn();
+
+    setRateFactor (getAllowedRateFactor());
+
+    startOscillators();
 
     for (auto& a : filterADSRs)
         a.noteOn();
@@ -64,6 +102,7 @@ void VirtualAnalogVoice::noteStarted()
 
     modStepLFO.reset();
     modStepLFO.noteOn();
+    stepLfoLength = -1;
 
     adsr.reset();
     adsr.noteOn();
@@ -71,6 +110,8 @@ void VirtualAnalogVoice::noteStarted()
 
 void VirtualAnalogVoice::noteRetriggered()
 {
+    proc.voiceAllocator.voiceStarted (index, getCurrentlyPlayingNote().initialNote);
+
     auto note = getCurrentlyPlayingNote();
     
     if (glideInfo.fromNote != -1 && (glideInfo.glissando || glideInfo.portamento))
@@ -84,13 +125,14 @@ void VirtualAnalogVoice::noteRetriggered()
     }
     
     proc.modMatrix.setPolyValue (*this, proc.modSrcVelocity, note.noteOnVelocity.asUnsignedFloat());
-    proc.modMatrix.setPolyValue (*this, proc.modSrcTimbre, note.initialTimbre.asUnsignedFloat());
+    proc.modMatrix.setPolyValue (*this, proc.modSrcTimbre, note.timbre.asUnsignedFloat());
     proc.modMatrix.setPolyValue (*this, proc.modSrcPressure, note.pressure.asUnsignedFloat());
+    startExpression (note);
     
     updateParams (0);
+    setRateFactor (getAllowedRateFactor());
 
-    for (auto& osc : oscillators)
-        osc.noteOn();
+    startOscillators();
 
     for (auto& a : filterADSRs)
         a.noteOn();
@@ -116,19 +158,65 @@ void VirtualAnalogVoice::noteStopped (bool allowTailOff)
     {
         clearCurrentNote();
         stopVoice();
+        proc.voiceAllocator.voiceFinished (index);
+    }
+    else
+    {
+        proc.voiceAllocator.voiceReleased (index);
     }
 }
 
 void VirtualAnalogVoice::notePressureChanged()
 {
-    auto note = getCurrentlyPlayingNote();
-    proc.modMatrix.setPolyValue (*this, proc.modSrcPressure, note.pressure.asUnsignedFloat());
+    if (proc.mpeMessageTiming)
+    {
+        auto note = getCurrentlyPlayingNote();
+        proc.modMatrix.setPolyValue (*this, proc.modSrcPressure, note.pressure.asUnsignedFloat());
+    }
+    else
+    {
+        expressionChanged = true;
+    }
 }
 
 void VirtualAnalogVoice::noteTimbreChanged()
 {
-    auto note = getCurrentlyPlayingNote();
-    proc.modMatrix.setPolyValue (*this, proc.modSrcTimbre, note.initialTimbre.asUnsignedFloat());
+    if (proc.mpeMessageTiming)
+    {
+        auto note = getCurrentlyPlayingNote();
+        proc.modMatrix.setPolyValue (*this, proc.modSrcTimbre, note.timbre.asUnsignedFloat());
+    }
+    else
+    {
+        expressionChanged = true;
+    }
+}
+
+void VirtualAnalogVoice::startExpression (const juce::MPENote& note)
+{
+    expressionChanged = false;
+
+    pressure.reset (getSampleRate(), proc.mpeSmoothing);
+    timbre.reset (getSampleRate(), proc.mpeSmoothing);
+
+    pressure.setCurrentAndTargetValue (note.pressure.asUnsignedFloat());
+    timbre.setCurrentAndTargetValue (note.timbre.asUnsignedFloat());
+}
+
+void VirtualAnalogVoice::updateExpression (const juce::MPENote& note, int blockSize)
+{
+    if (expressionChanged)
+    {
+        pressure.setTargetValue (note.pressure.asUnsignedFloat());
+        timbre.setTargetValue (note.timbre.asUnsignedFloat());
+    }
+
+    if (expressionChanged || pressure.isSmoothing() || timbre.isSmoothing())
+    {
+        proc.modMatrix.setPolyValue (*this, proc.modSrcPressure, pressure.skip (blockSize));
+        proc.modMatrix.setPolyValue (*this, proc.modSrcTimbre, timbre.skip (blockSize));
+        expressionChanged = false;
+    }
 }
 
 void VirtualAnalogVoice::setCurrentSampleRate (double newRate)
@@ -150,41 +238,233 @@ void VirtualAnalogVoice::setCurrentSampleRate (double newRate)
     modStepLFO.setSampleRate (newRate);
     noteSmoother.setSampleRate (newRate);
     adsr.setSampleRate (newRate);
+
+    setRateFactor (1);
+}
+
+int VirtualAnalogVoice::getAllowedRateFactor() const
+{
+    if (! proc.multirateVoices)
+        return 1;
+
+    // Filters run in series, so one 24 dB lowpass is enough as long as none
+    // of the active filters can go higher than the reduced rate handles well.
+    // At 0.1 of the reduced rate it leaves the upsampler's images at least
+    // 85 dB under the signal, a 12 dB one only 61 dB, so that doesn't count.
+    float maxHz = 0.0f;
+    bool lowpassed = false;
+
+    for (int i = 0; i < Cfg::numFilters; i++)
+    {
+        if (! filterActive[i])
+            continue;
+
+        maxHz = std::max (maxHz, filterMaxHz[i]);
+        lowpassed = lowpassed || filterLowpass[i];
+    }
+
+    if (! lowpassed)
+        return 1;
+
+    for (int factor = Upsampler::maxFactor; factor > 1; factor /= 2)
+        if (maxHz <= maxMultirateCutoff * float (getSampleRate()) / float (factor))
+            return factor;
+
+    return 1;
+}
+
+void VirtualAnalogVoice::setRateFactor (int factor)
+{
+    rateFactor = factor;
+
+    auto rate = getSampleRate() / factor;
+
+    for (auto& osc : oscillators)
+        osc.setSampleRate (rate);
+
+    for (auto& f : filters)
+        f.setSampleRate (rate);
+
+    for (auto& u : upsamplers)
+        u.setFactor (factor);
+
+    numCarried = 0;
+    numToSkip  = upsamplers[0].getLatency();
+}
+
+void VirtualAnalogVoice::renderReduced (juce::AudioSampleBuffer& buffer)
+{
+    auto numSamples  = buffer.getNumSamples();
+    auto numChannels = buffer.getNumChannels();
+
+    // Upsampled samples left over from the last block go first
+    auto fromCarry = std::min (numCarried, numSamples);
+
+    for (int ch = 0; ch < numChannels; ch++)
+        std::copy (carried[ch], carried[ch] + fromCarry, buffer.getWritePointer (ch));
+
+    for (int ch = 0; ch < 2; ch++)
+        std::copy (carried[ch] + fromCarry, carried[ch] + numCarried, carried[ch]);
+
+    numCarried -= fromCarry;
+
+    auto needed = numSamples - fromCarry;
+    if (needed <= 0)
+        return;
+
+    // At the start of a note the upsampler's delay is rendered and thrown
+    // away, so the voice lines up with the amp envelope
+    auto skip = numToSkip;
+    numToSkip = 0;
+
+    auto numReduced = (skip + needed + rateFactor - 1) / rateFactor;
+
+    auto reduced = getScratch (reducedScratch, numChannels, numReduced);
+    (this->*render) (reduced);
+
+    auto upsampled = getScratch (upsampledScratch, numChannels, numReduced * rateFactor);
+    for (int ch = 0; ch < numChannels; ch++)
+        upsamplers[ch].process (reduced.getReadPointer (ch), upsampled.getWritePointer (ch), numReduced);
+
+    // Keep the right side's history in step for when the voice goes stereo
+    if (numChannels == 1)
+        upsamplers[1] = upsamplers[0];
+
+    numCarried = numReduced * rateFactor - skip - needed;
+
+    for (int ch = 0; ch < 2; ch++)
+    {
+        auto src = upsampled.getReadPointer (std::min (ch, numChannels - 1)) + skip;
+
+        if (ch < numChannels)
+            std::copy (src, src + needed, buffer.getWritePointer (ch, fromCarry));
+
+        std::copy (src + needed, src + needed + numCarried, carried[ch]);
+    }
 }
 
 void VirtualAnalogVoice::renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+{
+    finishRender (renderVoice (outputBuffer, startSample, numSamples), numSamples);
+}
+
+bool VirtualAnalogVoice::renderVoice (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
 {
     updateParams (numSamples);
 
-    // Run OSC
-    gin::ScratchBuffer buffer (2, numSamples);
+    // Run OSC and apply filters
+    auto buffer = getScratch (mixScratch, monoBlock ? 1 : 2, numSamples);
 
-    for (int i = 0; i < Cfg::numOSCs; i++)
-        if (proc.oscParams[i].enable->isOn())
-            oscillators[i].processAdding (currentMidiNotes[i], oscParams[i], buffer);
+    if (rateFactor > 1)
+        renderReduced (buffer);
+    else
+        (this->*render) (buffer);
 
-    // Apply velocity
+    // Velocity and the amp envelope are one gain per sample, applied as the
+    // voice is added to the synth so the buffer is only read once. The
+    // filters are linear, so the velocity can come after them.
     float velocity = currentlyPlayingNote.noteOnVelocity.asUnsignedFloat();
-    buffer.applyGain (gin::velocityToGain (velocity, ampKeyTrack));
+    auto gain = gin::velocityToGain (velocity, ampKeyTrack);
 
-    // Apply filters
-    for (int i = 0; i < juce::numElementsInArray (filters); i++)
-        if (proc.filterParams[i].enable->isOn())
-            filters[i].process (buffer);
-    
-    // Run ADSR
-    adsr.processMultiplying (buffer);
-    
-    if (adsr.getState() == gin::AnalogADSR::State::idle)
+    float env[64];
+    for (int done = 0; done < numSamples; done += 64)
+    {
+        auto todo = std::min (64, numSamples - done);
+
+        for (int i = 0; i < todo; i++)
+            env[i] = adsr.process() * gain;
+
+        for (int ch = 0; ch < 2; ch++)
+            juce::FloatVectorOperations::addWithMultiply (outputBuffer.getWritePointer (ch, startSample + done),
+                                                          buffer.getReadPointer (monoBlock ? 0 : ch, done),
+                                                          env, todo);
+    }
+
+    return adsr.getState() != gin::AnalogADSR::State::idle;
+}
+
+namespace
+{
+    /** Calls fn (i) for each bit set in mask, the tests fold away at compile time */
+    template <unsigned mask, typename Fn, int... bits>
+    void forEachBit (Fn&& fn, std::integer_sequence<int, bits...>)
+    {
+        ((((mask >> bits) & 1u) != 0 ? fn (bits) : void()), ...);
+    }
+}
+
+template <unsigned oscMask, unsigned filterMask>
+void VirtualAnalogVoice::renderVariant (juce::AudioSampleBuffer& buffer)
+{
+    forEachBit<oscMask> ([&] (int i) { oscillators[i].processAdding (currentMidiNotes[i], oscParams[i], buffer); },
+                         std::make_integer_sequence<int, Cfg::numOSCs>());
+
+    forEachBit<filterMask> ([&] (int i)
+                            {
+                                if (filterFade[i] != 0)
+                                    processFilterFade (i, buffer);
+                                else
+                                    filters[i].processRamp (buffer, filterStart[i], filterEnd[i], filterQ[i]);
+                            },
+                            std::make_integer_sequence<int, Cfg::numFilters>());
+}
+
+void VirtualAnalogVoice::processFilterFade (int i, juce::AudioSampleBuffer& buffer)
+{
+    auto numSamples  = buffer.getNumSamples();
+    auto numChannels = buffer.getNumChannels();
+
+    auto dry = getScratch (dryScratch, numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ch++)
+        dry.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+
+    filters[i].processRamp (buffer, filterStart[i], filterEnd[i], filterQ[i]);
+
+    bool fadingIn = filterFade[i] > 0;
+    auto left = std::abs (filterFade[i]);
+    auto todo = std::min (left, numSamples);
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        auto in  = dry.getReadPointer (ch);
+        auto out = buffer.getWritePointer (ch);
+
+        for (int s = 0; s < todo; s++)
+        {
+            auto wet = float (left - s) / float (filterFadeLength);
+            if (fadingIn)
+                wet = 1.0f - wet;
+
+            out[s] = in[s] + (out[s] - in[s]) * wet;
+        }
+
+        if (! fadingIn)
+            std::copy (in + todo, in + numSamples, out + todo);
+    }
+
+    left -= todo;
+    filterFade[i] = fadingIn ? left : -left;
+
+    if (! fadingIn && left == 0)
+        filterActive[i] = false;
+}
+
+const std::array<VirtualAnalogVoice::RenderVariant, VirtualAnalogVoice::numRenderVariants> VirtualAnalogVoice::renderVariants
+    = VirtualAnalogVoice::makeRenderVariants (std::make_integer_sequence<int, VirtualAnalogVoice::numRenderVariants>());
+
+void VirtualAnalogVoice::finishRender (bool stillActive, int numSamples)
+{
+    if (! stillActive)
     {
         clearCurrentNote();
         stopVoice();
+        proc.voiceAllocator.voiceFinished (index);
+    }
+    else
+    {
+        proc.voiceAllocator.setLevel (index, adsr.getOutput());
     }
 
-    // Copy output to synth
-    outputBuffer.addFrom (0, startSample, buffer, 0, 0, numSamples);
-    outputBuffer.addFrom (1, startSample, buffer, 1, 0, numSamples);
-    
     finishBlock (numSamples);
 }
 
@@ -193,32 +473,58 @@ void VirtualAnalogVoice::updateParams (int blockSize)
     auto note = getCurrentlyPlayingNote();
     
     proc.modMatrix.setPolyValue (*this, proc.modSrcNote, note.initialNote / 127.0f);
+    updateExpression (note, blockSize);
+
+    monoBlock = true;
 
     for (int i = 0; i < Cfg::numOSCs; i++)
     {
+        // Level already includes any modulation, at -100 dB nothing can be heard this block
+        oscAudible[i] = false;
         if (! proc.oscParams[i].enable->isOn()) continue;
-        
+
+        // A table replaces the wave
+        auto table = int (proc.oscParams[i].table->getProcValue());
+
+        oscParams[i].wave = table > 0 ? gin::Wave::wavetable : (gin::Wave) int (proc.oscParams[i].wave->getProcValue());
+        oscParams[i].gain = getValue (proc.oscParams[i].level);
+        if (oscParams[i].wave == gin::Wave::silence || oscParams[i].gain <= 0.0f) continue;
+
+        oscAudible[i] = true;
+
         currentMidiNotes[i] = noteSmoother.getCurrentValue() * 127.0f;
         if (glideInfo.glissando) currentMidiNotes[i] = (float) juce::roundToInt (currentMidiNotes[i]);
         currentMidiNotes[i] += float (note.totalPitchbendInSemitones);
         currentMidiNotes[i] += getValue (proc.oscParams[i].tune) + getValue (proc.oscParams[i].finetune) / 100.0f;
 
-        oscParams[i].wave   = (gin::Wave) int (proc.oscParams[i].wave->getProcValue());
-        oscParams[i].voices = int (proc.oscParams[i].voices->getProcValue());
+        oscParams[i].voices = std::min (int (proc.oscParams[i].voices->getProcValue()),
+                                        proc.qualityGovernor.getCurrentLevel().maxUnison);
         oscParams[i].vcTrns = int (proc.oscParams[i].voicesTrns->getProcValue());
         oscParams[i].pw     = getValue (proc.oscParams[i].pulsewidth) / 100.0f;
         oscParams[i].pan    = getValue (proc.oscParams[i].pan);
         oscParams[i].spread = getValue (proc.oscParams[i].spread) / 100.0f;
         oscParams[i].detune = getValue (proc.oscParams[i].detune);
-        oscParams[i].gain   = getValue (proc.oscParams[i].level);
+        oscParams[i].table  = table - 1;
+        oscParams[i].frame  = getValue (proc.oscParams[i].frame);
+
+        // Centred with no spread, every unison voice is panned to the middle
+        if (oscParams[i].pan != 0.0f || (oscParams[i].voices > 1 && oscParams[i].spread != 0.0f))
+            monoBlock = false;
     }
     
     ampKeyTrack = getValue (proc.adsrParams.velocityTracking);
 
+    auto isModulated = [this] (gin::Parameter::Ptr p)
+    {
+        return proc.modMatrix.isModulated (gin::ModDstId (p->getModIndex()));
+    };
+
     for (int i = 0; i < Cfg::numFilters; i++)
     {
         if (! proc.filterParams[i].enable->isOn())
         {
+            filterActive[i] = false;
+            filterFade[i] = 0;
             proc.modMatrix.setPolyValue (*this, proc.modSrcFilter[i], 0);
             continue;
         }
@@ -230,7 +536,7 @@ void VirtualAnalogVoice::updateParams (int blockSize)
 
         filterADSRs[i].process (blockSize);
 
-        float filterWidth = float (gin::getMidiNoteFromHertz (20000.0));
+        float filterWidth = FastMath::hzToNote (20000.0f);
         float filterEnv   = filterADSRs[i].getOutput();
         float filterSens = getValue (proc.filterParams[i].velocityTracking);
         filterSens = currentlyPlayingNote.noteOnVelocity.asUnsignedFloat() * filterSens + 1.0f - filterSens;
@@ -239,53 +545,126 @@ void VirtualAnalogVoice::updateParams (int blockSize)
         n += (currentlyPlayingNote.initialNote - 60) * getValue (proc.filterParams[i].keyTracking);
         n += filterEnv * filterSens * getValue (proc.filterParams[i].amount) * filterWidth;
 
-        float f = gin::getMidiNoteInHertz (n);
+        float f = FastMath::noteToHz (n);
         float maxFreq = std::min (20000.0f, float (getSampleRate() / 2));
         f = juce::jlimit (4.0f, maxFreq, f);
 
-        float q = gin::Q / (1.0f - (getValue (proc.filterParams[i].resonance) / 100.0f) * 0.99f);
+        // The rate is fixed for the note, a cutoff moved past what it handles
+        // is held at the limit until the next note
+        if (rateFactor > 1 && blockSize > 0)
+            f = std::min (f, maxMultirateCutoff * float (getSampleRate()) / float (rateFactor));
+
+        float res = getValue (proc.filterParams[i].resonance);
+        float q = gin::Q / (1.0f - (res / 100.0f) * 0.99f);
+
+        int type = int (proc.filterParams[i].type->getProcValue());
+
+        // A lowpass all the way open or a highpass all the way closed, with no
+        // resonance, envelope or modulation that could move it, is skipped.
+        // It still cuts the very top or the DC, so it fades in and out
+        // rather than switching.
+        bool wideOpen = res == 0.0f
+                     && getValue (proc.filterParams[i].amount) == 0.0f
+                     && ! isModulated (proc.filterParams[i].frequency)
+                     && ! isModulated (proc.filterParams[i].resonance)
+                     && ! isModulated (proc.filterParams[i].amount)
+                     && (((type == 0 || type == 1) && f >= maxFreq) || ((type == 2 || type == 3) && f <= 4.0f));
+
+        // The highest the cutoff can reach with the envelope fully open, for
+        // choosing the voice's rate. Modulation could take it anywhere.
+        if (proc.multirateVoices)
+        {
+            bool bounded = ! isModulated (proc.filterParams[i].frequency)
+                        && ! isModulated (proc.filterParams[i].keyTracking)
+                        && ! isModulated (proc.filterParams[i].amount);
+
+            float maxNote = getValue (proc.filterParams[i].frequency)
+                          + (currentlyPlayingNote.initialNote - 60) * getValue (proc.filterParams[i].keyTracking)
+                          + std::max (0.0f, getValue (proc.filterParams[i].amount)) * filterWidth;
 
-        switch (int (proc.filterParams[i].type->getProcValue()))
+            filterMaxHz[i]   = bounded ? FastMath::noteToHz (maxNote) : std::numeric_limits<float>::max();
+            filterLowpass[i] = type == 1;
+        }
+
+        // Starting a note or a filter jumps straight to the cutoff
+        filterStart[i] = blockSize == 0 ? f : filterEnd[i];
+        filterEnd[i]   = f;
+        filterQ[i]     = q;
+
+        if (! wideOpen && ! filterActive[i])
+        {
+            filters[i].reset();
+            filterStart[i] = f;
+            filterActive[i] = true;
+            filterFade[i] = disableSmoothing ? 0 : filterFadeLength;
+        }
+        else if (! wideOpen && filterFade[i] < 0)
+        {
+            filterFade[i] += filterFadeLength;
+        }
+        else if (wideOpen && filterActive[i])
+        {
+            // Once faded out the filter stops itself
+            if (disableSmoothing)
+            {
+                filterActive[i] = false;
+                filterFade[i] = 0;
+            }
+            else if (filterFade[i] >= 0)
+            {
+                filterFade[i] -= filterFadeLength;
+            }
+        }
+
+        switch (type)
         {
             case 0:
-                filters[i].setType (gin::Filter::lowpass);
-                filters[i].setSlope (gin::Filter::db12);
+                filters[i].setType (StereoSVF::lowpass);
+                filters[i].setSlope (StereoSVF::db12);
                 break;
             case 1:
-                filters[i].setType (gin::Filter::lowpass);
-                filters[i].setSlope (gin::Filter::db24);
+                filters[i].setType (StereoSVF::lowpass);
+                filters[i].setSlope (StereoSVF::db24);
                 break;
             case 2:
-                filters[i].setType (gin::Filter::highpass);
-                filters[i].setSlope (gin::Filter::db12);
+                filters[i].setType (StereoSVF::highpass);
+                filters[i].setSlope (StereoSVF::db12);
                 break;
             case 3:
-                filters[i].setType (gin::Filter::highpass);
-                filters[i].setSlope (gin::Filter::db24);
+                filters[i].setType (StereoSVF::highpass);
+                filters[i].setSlope (StereoSVF::db24);
                 break;
             case 4:
-                filters[i].setType (gin::Filter::bandpass);
-                filters[i].setSlope (gin::Filter::db12);
+                filters[i].setType (StereoSVF::bandpass);
+                filters[i].setSlope (StereoSVF::db12);
                 break;
             case 5:
-                filters[i].setType (gin::Filter::bandpass);
-                filters[i].setSlope (gin::Filter::db24);
+                filters[i].setType (StereoSVF::bandpass);
+                filters[i].setSlope (StereoSVF::db24);
                 break;
             case 6:
-                filters[i].setType (gin::Filter::notch);
-                filters[i].setSlope (gin::Filter::db12);
+                filters[i].setType (StereoSVF::notch);
+                filters[i].setSlope (StereoSVF::db12);
                 break;
             case 7:
-                filters[i].setType (gin::Filter::notch);
-                filters[i].setSlope (gin::Filter::db24);
+                filters[i].setType (StereoSVF::notch);
+                filters[i].setSlope (StereoSVF::db24);
                 break;
         }
-        
-        filters[i].setParams (f, q);
 
         proc.modMatrix.setPolyValue (*this, proc.modSrcFilter[i], filterADSRs[i].getOutput());
     }
 
+    unsigned variant = 0;
+    for (int i = 0; i < Cfg::numOSCs; i++)
+        if (oscAudible[i])
+            variant |= 1u << i;
+    for (int i = 0; i < Cfg::numFilters; i++)
+        if (filterActive[i])
+            variant |= 1u << (Cfg::numOSCs + i);
+
+    render = renderVariants[variant];
+
     for (int i = 0; i < Cfg::numENVs; i++)
     {
         if (proc.envParams[i].enable->isOn())
@@ -313,7 +692,7 @@ void VirtualAnalogVoice::updateParams (int blockSize)
 
             float freq = 0;
             if (proc.lfoParams[i].sync->getProcValue() > 0.0f)
-                freq = 1.0f / gin::NoteDuration::getNoteDurations()[size_t (proc.lfoParams[i].beat->getProcValue())].toSeconds (proc.playhead);
+                freq = proc.lfoSyncedFreq[i];
             else
                 freq = getValue (proc.lfoParams[i].rate);
 
@@ -339,14 +718,10 @@ void VirtualAnalogVoice::updateParams (int blockSize)
     // Update Step LFO
     if (proc.stepLfoParams.enable->isOn())
     {
-        float freq = 1.0f / gin::NoteDuration::getNoteDurations()[size_t (proc.stepLfoParams.beat->getProcValue())].toSeconds (proc.playhead);
-
-        modStepLFO.setFreq (freq);
+        modStepLFO.setFreq (proc.stepLfoSyncedFreq);
         
         int n = int (proc.stepLfoParams.length->getProcValue());
-        modStepLFO.setNumPoints (n);
-        for (int i = n; --i >= 0;)
-            modStepLFO.setPoint (i, proc.stepLfoParams.level[i]->getProcValue());
+        proc.stepPatterns.applyTo (modStepLFO, n, stepLfoVersion, stepLfoLength);
         
         modStepLFO.process (blockSize);
 
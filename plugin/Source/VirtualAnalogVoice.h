@@ -2,6 +2,9 @@
 
 #include <JuceHeader.h>
 #include "Cfg.h"
+#include "UnisonOscillator.h"
+#include "StereoSVF.h"
+#include "Upsampler.h"
 
 class VirtualAnalogAudioProcessor;
 
@@ -10,8 +13,24 @@ class VirtualAnalogVoice : public gin::SynthesiserVoice,
                            public gin::ModVoice
 {
 public:
-    VirtualAnalogVoice (VirtualAnalogAudioProcessor& p, gin::BandLimitedLookupTables& bandLimitedLookupTables);
-    
+    /** What the oscillators and filters write every sample, kept apart from
+        the rest of the voice by VoiceArena
+    */
+    struct HotState
+    {
+        UnisonOscillator::State oscillators[Cfg::numOSCs];
+        StereoSVF::State filters[Cfg::numFilters];
+    };
+
+    VirtualAnalogVoice (VirtualAnalogAudioProcessor& p, int index, HotState& hot);
+
+    void setLookupTables (const OscillatorTables& tables);
+
+    /** Noise and start phases follow from the voice index and how many notes
+        it has played since the last reset, so offline renders repeat exactly
+    */
+    void resetSeed()                        { noteCount = 0; }
+
     void noteStarted() override;
     void noteRetriggered() override;
     void noteStopped (bool allowTailOff) override;
@@ -25,37 +44,123 @@ public:
 
     void renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
 
+    /** renderNextBlock in two halves so the rendering can run on a worker
+        thread. renderVoice only touches this voice and returns false once the
+        note has finished, finishRender then has to be called on the audio
+        thread.
+    */
+    bool renderVoice (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples);
+    void finishRender (bool stillActive, int numSamples);
+
     bool isVoiceActive() override;
 
     float getFilterCutoffNormalized (int idx);
 
+    /** Everything the render works in, for locking into memory */
+    const juce::AudioSampleBuffer& getScratchStorage() const    { return scratch; }
+
 private:
     void updateParams (int blockSize);
+    void startOscillators();
 
-    VirtualAnalogAudioProcessor& proc;
-    gin::BandLimitedLookupTables& bandLimitedLookupTables;
+    /** Runs the oscillators in oscMask and the filters in filterMask, with
+        nothing tested per oscillator or filter. updateParams picks the one
+        for the current block from renderVariants.
+    */
+    template <unsigned oscMask, unsigned filterMask>
+    void renderVariant (juce::AudioSampleBuffer& buffer);
 
-    gin::BLLTVoicedStereoOscillator oscillators[Cfg::numOSCs] =
+    /** Runs filter i while it crossfades with its input, after it starts
+        or before it stops being skipped
+    */
+    void processFilterFade (int i, juce::AudioSampleBuffer& buffer);
+
+    /** Cleared space for one step of the render, from channels allocated with
+        the voice so rendering never allocates or shares a pool between threads
+    */
+    enum ScratchUse { mixScratch, reducedScratch, upsampledScratch, dryScratch, numScratchUses };
+    juce::AudioSampleBuffer getScratch (ScratchUse use, int numChannels, int numSamples);
+
+    using RenderVariant = void (VirtualAnalogVoice::*) (juce::AudioSampleBuffer&);
+
+    static constexpr int numRenderVariants = 1 << (Cfg::numOSCs + Cfg::numFilters);
+    static const std::array<RenderVariant, numRenderVariants> renderVariants;
+
+    template <int... variants>
+    static constexpr std::array<RenderVariant, sizeof... (variants)> makeRenderVariants (std::integer_sequence<int, variants...>)
     {
-        bandLimitedLookupTables,
-        bandLimitedLookupTables,
-        bandLimitedLookupTables,
-        bandLimitedLookupTables,
-    };
+        constexpr unsigned oscBits = (1u << Cfg::numOSCs) - 1;
+        return {{ &VirtualAnalogVoice::renderVariant<unsigned (variants) & oscBits, (unsigned (variants) >> Cfg::numOSCs)>... }};
+    }
+
+    /** With the multirateVoices setting, a voice whose 24 dB lowpass keeps
+        its cutoff under maxMultirateCutoff of a half or quarter rate runs its
+        oscillators and filters at that rate, then upsamples. The rate is
+        picked at note on and kept until the next one.
+    */
+    int getAllowedRateFactor() const;
+    void setRateFactor (int factor);
+    void renderReduced (juce::AudioSampleBuffer& buffer);
+
+    static constexpr float maxMultirateCutoff = 0.1f;
+
+    /** Pressure and timbre messages only flag a change, the latest values
+        reach the mod matrix once a block, ramped if mpeSmoothing is set
+    */
+    void startExpression (const juce::MPENote& note);
+    void updateExpression (const juce::MPENote& note, int blockSize);
+
+    VirtualAnalogAudioProcessor& proc;
+    HotState& hot;
 
-    gin::Filter filters[Cfg::numFilters];
+    // Used all through the render
+    UnisonOscillator oscillators[Cfg::numOSCs];
+    StereoSVF filters[Cfg::numFilters];
+    gin::AnalogADSR adsr;
+
+    float currentMidiNotes[Cfg::numOSCs];
+    UnisonOscillator::Params oscParams[Cfg::numOSCs];
+    bool oscAudible[Cfg::numOSCs] = {};
+    bool filterActive[Cfg::numFilters] = {};
+    bool monoBlock = false;                 // left and right are the same, render one side
+    RenderVariant render = &VirtualAnalogVoice::renderVariant<0, 0>;
+
+    // Cutoff moves from start to end across each block, following the envelope
+    float filterStart[Cfg::numFilters] = {};
+    float filterEnd[Cfg::numFilters] = {};
+    float filterQ[Cfg::numFilters] = {};
+
+    // Samples left in a crossfade, positive fading the filter in, negative fading it out
+    int filterFade[Cfg::numFilters] = {};
+    static constexpr int filterFadeLength = 128;
+
+    int rateFactor = 1;
+    Upsampler upsamplers[2];
+    float carried[2][Upsampler::maxFactor] = {};
+    int numCarried = 0;
+    int numToSkip = 0;
+
+    juce::AudioSampleBuffer scratch;
+
+    float ampKeyTrack = 1.0f;
+
+    float filterMaxHz[Cfg::numFilters] = {};
+    bool filterLowpass[Cfg::numFilters] = {};
+
+    // Modulation, run once a block
     gin::ADSR filterADSRs[Cfg::numFilters];
-    
     gin::ADSR modADSRs[Cfg::numENVs];
     gin::LFO modLFOs[Cfg::numLFOs];
     gin::StepLFO modStepLFO;
+    juce::uint32 stepLfoVersion = 0;
+    int stepLfoLength = -1;
 
-    gin::AnalogADSR adsr;
-
-    float currentMidiNotes[Cfg::numOSCs];
-    gin::BLLTVoicedStereoOscillator::Params oscParams[Cfg::numOSCs];
-    
     gin::EasedValueSmoother<float> noteSmoother;
-    
-    float ampKeyTrack = 1.0f;
+
+    juce::SmoothedValue<float> pressure, timbre;
+    bool expressionChanged = false;
+
+    // Only at note on
+    const int index;
+    juce::uint32 noteCount = 0;
 };
@@ -0,0 +1,263 @@
+#include "VoiceAllocator.h"
+#include "FastMath.h"
+
+//==============================================================================
+void VoiceAllocator::setNumVoices (int n)
+{
+    keys.assign (size_t (n), {});
+    heap.assign (size_t (n), -1);
+    heapPos.assign (size_t (n), -1);
+    nextFree.resize (size_t (n));
+    prevFree.resize (size_t (n));
+
+    heapSize = 0;
+    nextAge  = 0;
+
+    playingPerNote.fill (0);
+    heldPerNote.fill (0);
+
+    // Lowest index first, the same order a linear search would find them in
+    for (int i = 0; i < n; i++)
+    {
+        nextFree[size_t (i)] = i + 1 < n ? i + 1 : -1;
+        prevFree[size_t (i)] = i - 1;
+    }
+    freeHead = n > 0 ? 0 : -1;
+}
+
+void VoiceAllocator::voiceStarted (int index, int note)
+{
+    auto& k = keys[size_t (index)];
+
+    // A stolen or retriggered voice is already playing
+    bool playing = heapPos[size_t (index)] >= 0;
+    if (playing)
+        noteOff (k);
+
+    noteOn (k, note);
+    k.level = getLevelStep (1.0f);
+    k.age   = nextAge++;
+
+    if (playing)
+    {
+        update (index);
+    }
+    else
+    {
+        removeFree (index);
+        insert (index);
+    }
+}
+
+void VoiceAllocator::voiceReleased (int index)
+{
+    if (heapPos[size_t (index)] < 0)
+        return;
+
+    auto& k = keys[size_t (index)];
+    if (k.held && juce::isPositiveAndBelow (k.note, 128))
+        heldPerNote[size_t (k.note)]--;
+
+    k.held = false;
+    update (index);
+}
+
+void VoiceAllocator::voiceFinished (int index)
+{
+    if (heapPos[size_t (index)] < 0)
+        return;
+
+    noteOff (keys[size_t (index)]);
+    remove (index);
+    pushFree (index);
+}
+
+int VoiceAllocator::getVoiceToSteal (int note) const
+{
+    if (heapSize == 0)
+        return -1;
+
+    // The oldest, or least heard, voice already on the note. Searched only
+    // when there is one.
+    if (juce::isPositiveAndBelow (note, 128) && playingPerNote[size_t (note)] > 0)
+    {
+        int best = -1;
+        for (int pos = 0; pos < heapSize; pos++)
+        {
+            auto idx = heap[size_t (pos)];
+            if (keys[size_t (idx)].note == note && (best < 0 || keys[size_t (idx)] < keys[size_t (best)]))
+                best = idx;
+        }
+
+        if (best >= 0)
+            return best;
+    }
+
+    // The lowest and highest held notes are kept, a single held note counts as the lowest
+    int low = -1, high = -1;
+    for (int n = 0; n < 128 && low < 0; n++)
+        if (heldPerNote[size_t (n)] > 0)
+            low = n;
+    for (int n = 127; n > low && high < 0; n--)
+        if (heldPerNote[size_t (n)] > 0)
+            high = n;
+
+    // With two voices protected, the next best is at most third in the order,
+    // so within the heap's top three levels
+    int best = -1;
+    for (int pos = 0; pos < std::min (heapSize, 7); pos++)
+    {
+        auto idx = heap[size_t (pos)];
+        auto& k  = keys[size_t (idx)];
+
+        if (k.held && (k.note == low || k.note == high))
+            continue;
+
+        if (best < 0 || k < keys[size_t (best)])
+            best = idx;
+    }
+
+    // Only protected voices left, take the one that would be heard least
+    return best >= 0 ? best : heap[0];
+}
+
+void VoiceAllocator::setLevel (int index, float gain)
+{
+    if (heapPos[size_t (index)] < 0)
+        return;
+
+    auto step = getLevelStep (gain);
+    if (step != keys[size_t (index)].level)
+    {
+        keys[size_t (index)].level = step;
+        update (index);
+    }
+}
+
+void VoiceAllocator::noteOn (Key& k, int note)
+{
+    k.held = true;
+    k.note = note;
+
+    if (juce::isPositiveAndBelow (note, 128))
+    {
+        playingPerNote[size_t (note)]++;
+        heldPerNote[size_t (note)]++;
+    }
+}
+
+void VoiceAllocator::noteOff (Key& k)
+{
+    if (juce::isPositiveAndBelow (k.note, 128))
+    {
+        playingPerNote[size_t (k.note)]--;
+        if (k.held)
+            heldPerNote[size_t (k.note)]--;
+    }
+
+    k.held = false;
+    k.note = -1;
+}
+
+int VoiceAllocator::getLevelStep (float gain)
+{
+    return juce::jlimit (0, 16, int ((FastMath::gainToDb (gain, -96.0f) + 96.0f) / 6.0f));
+}
+
+//==============================================================================
+void VoiceAllocator::removeFree (int index)
+{
+    auto n = nextFree[size_t (index)];
+    auto p = prevFree[size_t (index)];
+
+    if (p >= 0) nextFree[size_t (p)] = n;
+    else        freeHead = n;
+
+    if (n >= 0) prevFree[size_t (n)] = p;
+}
+
+void VoiceAllocator::pushFree (int index)
+{
+    nextFree[size_t (index)] = freeHead;
+    prevFree[size_t (index)] = -1;
+
+    if (freeHead >= 0)
+        prevFree[size_t (freeHead)] = index;
+
+    freeHead = index;
+}
+
+//==============================================================================
+void VoiceAllocator::insert (int index)
+{
+    place (heapSize++, index);
+    siftUp (heapSize - 1);
+}
+
+void VoiceAllocator::remove (int index)
+{
+    auto pos  = heapPos[size_t (index)];
+    auto last = heap[size_t (--heapSize)];
+
+    heap[size_t (heapSize)] = -1;
+    heapPos[size_t (index)] = -1;
+
+    if (last != index)
+    {
+        place (pos, last);
+        update (last);
+    }
+}
+
+void VoiceAllocator::update (int index)
+{
+    auto pos = heapPos[size_t (index)];
+    siftUp (pos);
+    siftDown (heapPos[size_t (index)]);
+}
+
+void VoiceAllocator::siftUp (int pos)
+{
+    auto index = heap[size_t (pos)];
+
+    while (pos > 0)
+    {
+        auto parent = (pos - 1) / 2;
+        if (! (keys[size_t (index)] < keys[size_t (heap[size_t (parent)])]))
+            break;
+
+        place (pos, heap[size_t (parent)]);
+        pos = parent;
+    }
+
+    place (pos, index);
+}
+
+void VoiceAllocator::siftDown (int pos)
+{
+    auto index = heap[size_t (pos)];
+
+    while (true)
+    {
+        auto child = pos * 2 + 1;
+        if (child >= heapSize)
+            break;
+
+        if (child + 1 < heapSize && keys[size_t (heap[size_t (child + 1)])] < keys[size_t (heap[size_t (child)])])
+            child++;
+
+        if (! (keys[size_t (heap[size_t (child)])] < keys[size_t (index)]))
+            break;
+
+        place (pos, heap[size_t (child)]);
+        pos = child;
+    }
+
+    place (pos, index);
+}
+
+void VoiceAllocator::place (int pos, int index)
+{
+    heap[size_t (pos)] = index;
+    heapPos[size_t (index)] = pos;
+}
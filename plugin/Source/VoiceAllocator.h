@@ -0,0 +1,84 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Keeps track of which voices are free and which to steal, so a note on
+    doesn't have to look at every voice. Voices are referred to by index.
+
+    Free voices are on a linked list, taking or returning one is O(1).
+    Playing voices are in a heap ordered by how little stealing them would be
+    heard: released before held, then quietest, then oldest. Starting,
+    releasing and level changes are O(log n), and the level only moves the
+    voice in the heap when it crosses into another 6 dB step.
+
+    Stealing keeps MPESynthesiser's rules on top of that order: a voice
+    already playing the new note goes first, and the lowest and highest held
+    notes are only taken when nothing else is left.
+
+    Audio thread only.
+*/
+class VoiceAllocator
+{
+public:
+    /** All voices start free */
+    void setNumVoices (int n);
+
+    void voiceStarted (int index, int note);
+    void voiceReleased (int index);
+    void voiceFinished (int index);
+    void setLevel (int index, float gain);
+
+    /** -1 if every voice is playing */
+    int getFreeVoice() const                { return freeHead; }
+
+    /** -1 if no voice is playing. note is the one that needs a voice, or -1. */
+    int getVoiceToSteal (int note) const;
+
+    int getNumActive() const                { return heapSize; }
+
+    /** Indexes of the playing voices, in no particular order */
+    const int* getActiveVoices() const      { return heap.data(); }
+
+private:
+    struct Key
+    {
+        bool held = false;
+        int note = -1;
+        int level = 0;
+        juce::uint32 age = 0;
+
+        /** True if this voice should be stolen before o */
+        bool operator< (const Key& o) const
+        {
+            if (held != o.held)   return ! held;
+            if (level != o.level) return level < o.level;
+            return int (age - o.age) < 0;
+        }
+    };
+
+    static int getLevelStep (float gain);
+
+    void noteOn (Key& k, int note);
+    void noteOff (Key& k);
+
+    void removeFree (int index);
+    void pushFree (int index);
+
+    void insert (int index);
+    void remove (int index);
+    void update (int index);
+    void siftUp (int pos);
+    void siftDown (int pos);
+    void place (int pos, int index);
+
+    std::vector<Key> keys;
+    std::vector<int> heap, heapPos;         // heapPos is -1 for free voices
+    std::vector<int> nextFree, prevFree;
+    int heapSize = 0;
+    int freeHead = -1;
+    juce::uint32 nextAge = 0;
+
+    // Voices on each note, all of them and just the held ones
+    std::array<int, 128> playingPerNote {}, heldPerNote {};
+};
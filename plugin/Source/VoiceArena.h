@@ -0,0 +1,90 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Builds all the voices of a synth in one block of memory, in index order and
+    each starting on a cache line, so walking the voices walks memory forwards.
+
+    The state each voice reads and writes every sample lives in a second
+    array of Hot, each entry starting on its own cache line so voices on
+    different threads never share one, away from the note info and parameter
+    caches that are only read once a block.
+    Voice is built with the hot state as its last constructor argument.
+
+    The synth must drop its pointers to the voices before the arena goes,
+    it doesn't own them.
+*/
+template <typename Voice, typename Hot>
+class VoiceArena
+{
+public:
+    VoiceArena() = default;
+    ~VoiceArena()                           { clear(); }
+
+    template <typename... Args>
+    void create (int n, Args&... args)
+    {
+        clear();
+
+        hotMemory.calloc (size_t (n) * hotStride + cacheLine);
+        voiceMemory.calloc (size_t (n) * voiceStride + cacheLine);
+
+        hotData   = align (hotMemory.get());
+        voiceData = align (voiceMemory.get());
+
+        for (int i = 0; i < n; i++)
+            new (hotData + size_t (i) * hotStride) Hot();
+
+        for (int i = 0; i < n; i++)
+            new (voiceData + size_t (i) * voiceStride) Voice (args..., i, getHotState (i));
+
+        numVoices = n;
+    }
+
+    void clear()
+    {
+        for (int i = numVoices; --i >= 0;)
+        {
+            getVoice (i)->~Voice();
+            getHotState (i).~Hot();
+        }
+
+        numVoices = 0;
+        voiceMemory.free();
+        hotMemory.free();
+    }
+
+    int size() const                        { return numVoices; }
+
+    Voice* getVoice (int i) const           { return reinterpret_cast<Voice*> (voiceData + size_t (i) * voiceStride); }
+    Hot& getHotState (int i) const          { return *reinterpret_cast<Hot*> (hotData + size_t (i) * hotStride); }
+
+    /** The two blocks, for locking into memory */
+    const void* getVoiceData() const        { return voiceData; }
+    size_t getVoiceDataSize() const         { return size_t (numVoices) * voiceStride; }
+    const void* getHotData() const          { return hotData; }
+    size_t getHotDataSize() const           { return size_t (numVoices) * hotStride; }
+
+private:
+    static constexpr size_t cacheLine = 64;
+
+    static constexpr size_t roundUp (size_t n)  { return (n + cacheLine - 1) / cacheLine * cacheLine; }
+
+    static char* align (char* p)
+    {
+        return reinterpret_cast<char*> (roundUp (reinterpret_cast<size_t> (p)));
+    }
+
+    static constexpr size_t voiceStride = roundUp (sizeof (Voice));
+    static constexpr size_t hotStride   = roundUp (sizeof (Hot));
+
+    static_assert (alignof (Voice) <= cacheLine && alignof (Hot) <= cacheLine, "Needs more than cache line alignment");
+
+    juce::HeapBlock<char> voiceMemory, hotMemory;
+    char* voiceData = nullptr;
+    char* hotData = nullptr;
+    int numVoices = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (VoiceArena)
+};
@@ -0,0 +1,237 @@
+#include "WavetableBank.h"
+
+namespace
+{
+    struct FileHeader
+    {
+        char magic[4];
+        juce::uint32 version;
+        juce::int64 hash;
+        juce::uint32 frameSize, numLevels, numTables, numFrames;
+        char reserved[32];
+    };
+
+    static_assert (sizeof (FileHeader) == 64, "Keep the table data 16 byte aligned");
+
+    const char fileMagic[4] = { 'V', 'A', 'W', 'T' };
+}
+
+//==============================================================================
+WavetableBank::WavetableBank()
+{
+    lookupTableCache->addJob ([this] { loadOrBuild(); });
+}
+
+WavetableBank::~WavetableBank()
+{
+    // The job holds this
+    waitUntilLoaded();
+}
+
+void WavetableBank::loadOrBuild()
+{
+    auto files = getWavetableDirectory().findChildFiles (juce::File::findFiles, false, "*.wav");
+    files.sort();
+
+    if (files.size() > maxTables)
+        files.removeRange (maxTables, files.size() - maxTables);
+
+    auto hash = getFolderHash (files);
+    auto f = getCacheFile();
+
+    if (! load (f, hash))
+    {
+        build (files);
+        save (f, hash);
+    }
+
+    loaded.signal();
+}
+
+size_t WavetableBank::lockMemory() const
+{
+    waitUntilLoaded();
+
+    std::call_once (lockOnce, [this]
+    {
+        memoryLock.lock (entries, size_t (getNumTables()) * sizeof (Entry));
+        memoryLock.lock (data, numFrames * numLevels * (frameSize + 1) * sizeof (float));
+    });
+
+    return memoryLock.getLockedBytes();
+}
+
+juce::File WavetableBank::getWavetableDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory).getChildFile ("SocaLabs/VirtualAnalog/Wavetables");
+}
+
+juce::File WavetableBank::getCacheFile()
+{
+   #if JUCE_MAC
+    auto dir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory).getChildFile ("Caches");
+   #else
+    auto dir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory);
+   #endif
+
+    return dir.getChildFile ("SocaLabs/VirtualAnalog/Tables")
+              .getChildFile (juce::String::formatted ("wavetables_v%d.bin", fileVersion));
+}
+
+juce::int64 WavetableBank::getFolderHash (const juce::Array<juce::File>& files)
+{
+    juce::String s;
+    for (auto& f : files)
+        s << f.getFileName() << ":" << f.getSize() << ":" << f.getLastModificationTime().toMilliseconds() << "\n";
+
+    return s.hashCode64();
+}
+
+juce::String WavetableBank::getTableName (int table) const
+{
+    if (! juce::isPositiveAndBelow (table, getNumTables()))
+        return {};
+
+    auto& e = entries[table];
+    return juce::String::fromUTF8 (e.name, int (strnlen (e.name, sizeof (e.name))));
+}
+
+int WavetableBank::getNumFrames (int table) const
+{
+    if (! juce::isPositiveAndBelow (table, getNumTables()))
+        return 0;
+
+    return int (entries[table].numFrames);
+}
+
+//==============================================================================
+bool WavetableBank::load (const juce::File& f, juce::int64 hash)
+{
+    if (! f.existsAsFile())
+        return false;
+
+    auto mm = std::make_unique<juce::MemoryMappedFile> (f, juce::MemoryMappedFile::readOnly);
+    if (mm->getData() == nullptr || mm->getSize() < sizeof (FileHeader))
+        return false;
+
+    auto header = (const FileHeader*) mm->getData();
+    if (memcmp (header->magic, fileMagic, sizeof (fileMagic)) != 0
+        || header->version   != juce::uint32 (fileVersion)
+        || header->hash      != hash
+        || header->frameSize != juce::uint32 (frameSize)
+        || header->numLevels != juce::uint32 (numLevels)
+        || header->numTables > juce::uint32 (maxTables))
+        return false;
+
+    auto tables = size_t (header->numTables);
+    auto frames = size_t (header->numFrames);
+
+    if (mm->getSize() != sizeof (FileHeader) + tables * sizeof (Entry) + frames * numLevels * (frameSize + 1) * sizeof (float))
+        return false;
+
+    numFrames = frames;
+    entries   = (const Entry*) juce::addBytesToPointer (mm->getData(), sizeof (FileHeader));
+    data      = (const float*) (entries + tables);
+    mapped    = std::move (mm);
+
+    numTables.store (int (tables), std::memory_order_release);
+    return true;
+}
+
+void WavetableBank::save (const juce::File& f, juce::int64 hash) const
+{
+    FileHeader header = {};
+    memcpy (header.magic, fileMagic, sizeof (fileMagic));
+    header.version      = juce::uint32 (fileVersion);
+    header.hash         = hash;
+    header.frameSize    = juce::uint32 (frameSize);
+    header.numLevels    = juce::uint32 (numLevels);
+    header.numTables    = juce::uint32 (getNumTables());
+    header.numFrames    = juce::uint32 (numFrames);
+
+    if (! f.getParentDirectory().createDirectory())
+        return;
+
+    // Write to a temp file and move it into place, other processes may be
+    // mapping or writing the same file
+    juce::TemporaryFile temp (f);
+
+    bool ok = false;
+    if (auto os = temp.getFile().createOutputStream())
+    {
+        ok = os->write (&header, sizeof (header))
+          && (getNumTables() == 0 || os->write (entries, size_t (getNumTables()) * sizeof (Entry)))
+          && (numFrames == 0 || os->write (data, storage.size() * sizeof (float)));
+
+        os->flush();
+        ok = ok && os->getStatus().wasOk();
+    }
+
+    if (ok)
+        temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+void WavetableBank::build (const juce::Array<juce::File>& files)
+{
+    static_assert ((1 << 11) == frameSize, "FFT order doesn't match the frame size");
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    juce::dsp::FFT fft (11);
+    std::vector<float> spectrum (size_t (frameSize) * 2), work (size_t (frameSize) * 2);
+
+    for (auto& f : files)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (f));
+        if (reader == nullptr)
+            continue;
+
+        auto frames = int (std::min (juce::int64 (maxFrames), reader->lengthInSamples / frameSize));
+        if (frames <= 0)
+            continue;
+
+        juce::AudioSampleBuffer buffer (1, frames * frameSize);
+        reader->read (&buffer, 0, frames * frameSize, 0, true, false);
+
+        Entry e = {};
+        f.getFileNameWithoutExtension().copyToUTF8 (e.name, sizeof (e.name));
+        e.numFrames  = juce::uint32 (frames);
+        e.firstFrame = juce::uint32 (numFrames);
+        entryStorage.push_back (e);
+
+        numFrames += size_t (frames);
+        storage.resize (numFrames * numLevels * (frameSize + 1));
+
+        for (int frame = 0; frame < frames; frame++)
+        {
+            std::fill (spectrum.begin(), spectrum.end(), 0.0f);
+            std::copy_n (buffer.getReadPointer (0, frame * frameSize), frameSize, spectrum.begin());
+
+            fft.performRealOnlyForwardTransform (spectrum.data(), true);
+
+            // Each level keeps half the harmonics of the one below it, DC is
+            // removed from all of them
+            for (int level = 0; level < numLevels; level++)
+            {
+                work = spectrum;
+                work[0] = work[1] = 0.0f;
+
+                for (int bin = (frameSize / 2 >> level) + 1; bin <= frameSize / 2; bin++)
+                    work[size_t (bin * 2)] = work[size_t (bin * 2 + 1)] = 0.0f;
+
+                fft.performRealOnlyInverseTransform (work.data());
+
+                auto dst = storage.data() + ((size_t (e.firstFrame) + size_t (frame)) * numLevels + size_t (level)) * (frameSize + 1);
+                std::copy_n (work.begin(), frameSize, dst);
+                dst[frameSize] = dst[0];
+            }
+        }
+    }
+
+    entries = entryStorage.data();
+    data    = storage.data();
+
+    numTables.store (int (entryStorage.size()), std::memory_order_release);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MemoryLock.h"
+#include "LookupTableCache.h"
+
+//==============================================================================
+/** The wavetables in the user's wavetable folder, band limited into one mip
+    level per octave and kept in a cache file that is memory mapped, so every
+    instance reads the same pages instead of loading its own copy. Hold it
+    with a juce::SharedResourcePointer.
+
+    Each .wav in the folder is one table, cut into frames of frameSize
+    samples. The cache is loaded, or rebuilt when the folder has changed, on
+    the LookupTableCache thread. Until then there are no tables.
+*/
+class WavetableBank
+{
+public:
+    WavetableBank();
+    ~WavetableBank();
+
+    static constexpr int frameSize      = 2048;
+    static constexpr int numLevels      = 11;
+    static constexpr int maxFrames      = 256;
+    static constexpr int maxTables      = 128;     // the table parameter goes to this, 0 is off
+    static constexpr int fileVersion    = 1;
+
+    static juce::File getWavetableDirectory();
+
+    bool isLoaded() const               { return loaded.wait (0); }
+    void waitUntilLoaded() const        { loaded.wait (-1); }
+
+    int getNumTables() const            { return numTables.load (std::memory_order_acquire); }
+    juce::String getTableName (int table) const;
+    int getNumFrames (int table) const;
+
+    /** Faults in and locks the tables, once for every user. Returns the bytes locked. */
+    size_t lockMemory() const;
+
+    /** Mip level with no harmonics above nyquist for a phase increment in cycles per sample */
+    static int getLevel (float delta) noexcept
+    {
+        auto level = int (std::ceil (std::log2 (std::max (1.0f, delta * frameSize))));
+        return juce::jlimit (0, numLevels - 1, level);
+    }
+
+    /** One band limited frame, with a guard sample at the end */
+    const float* getFrame (int table, int frame, int level) const noexcept
+    {
+        auto& e = entries[table];
+        return data + (size_t (e.firstFrame + juce::uint32 (frame)) * numLevels + size_t (level)) * (frameSize + 1);
+    }
+
+    static float lookup (const float* frame, float phase) noexcept
+    {
+        auto pos  = phase * frameSize;
+        auto i    = int (pos);
+        auto frac = pos - float (i);
+
+        return frame[i] + (frame[i + 1] - frame[i]) * frac;
+    }
+
+private:
+    struct Entry
+    {
+        char name[56];
+        juce::uint32 numFrames, firstFrame;
+    };
+
+    static juce::File getCacheFile();
+    static juce::int64 getFolderHash (const juce::Array<juce::File>& files);
+
+    void loadOrBuild();
+    bool load (const juce::File& f, juce::int64 hash);
+    void build (const juce::Array<juce::File>& files);
+    void save (const juce::File& f, juce::int64 hash) const;
+
+    juce::SharedResourcePointer<LookupTableCache> lookupTableCache;
+    juce::WaitableEvent loaded { true };
+
+    // Set last, once the entries and data are in place
+    std::atomic<int> numTables { 0 };
+    size_t numFrames = 0;
+
+    std::vector<Entry> entryStorage;
+    std::vector<float> storage;
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    const Entry* entries = nullptr;
+    const float* data = nullptr;
+
+    mutable std::once_flag lockOnce;
+    mutable MemoryLock memoryLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableBank)
+};
@@ -0,0 +1,166 @@
+#include "WorkerPool.h"
+#include "GlobalSettings.h"
+
+//==============================================================================
+bool WorkerPool::Queue::push (Task t)
+{
+    const juce::SpinLock::ScopedLockType sl (lock);
+
+    if (size == capacity)
+        return false;
+
+    tasks[(first + size) % capacity] = t;
+    size++;
+    return true;
+}
+
+bool WorkerPool::Queue::popBack (Task& t)
+{
+    const juce::SpinLock::ScopedLockType sl (lock);
+
+    if (size == 0)
+        return false;
+
+    size--;
+    t = tasks[(first + size) % capacity];
+    return true;
+}
+
+bool WorkerPool::Queue::stealFront (Task& t, const Batch* only)
+{
+    const juce::SpinLock::ScopedLockType sl (lock);
+
+    for (int i = 0; i < size; i++)
+    {
+        auto& e = tasks[(first + i) % capacity];
+        if (only != nullptr && e.batch != only)
+            continue;
+
+        // Fill the hole with the front task, the order within a queue doesn't matter
+        t = e;
+        e = tasks[first];
+        first = (first + 1) % capacity;
+        size--;
+        return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+WorkerPool::Worker::Worker (WorkerPool& p, int idx_)
+    : juce::Thread ("VA Worker " + juce::String (idx_ + 1)), pool (p), idx (idx_)
+{
+}
+
+void WorkerPool::Worker::run()
+{
+    while (! threadShouldExit())
+    {
+        // Own queue first, then the neighbours', sleep once there's nothing anywhere
+        Task t;
+        if (queue.popBack (t) || pool.steal (t, idx + 1))
+            runTask (t);
+        else
+            wake.wait (10);
+    }
+}
+
+//==============================================================================
+WorkerPool::WorkerPool()
+{
+    juce::SharedResourcePointer<GlobalSettings> settings;
+
+    auto defaultThreads = juce::jlimit (0, 16, juce::SystemStats::getNumCpus() - 1);
+    setNumThreads (settings->getInt ("workerThreads", defaultThreads));
+}
+
+WorkerPool::~WorkerPool()
+{
+    setNumThreads (0);
+}
+
+void WorkerPool::setNumThreads (int n)
+{
+    for (auto w : workers)
+        w->signalThreadShouldExit();
+
+    for (auto w : workers)
+    {
+        w->wake.signal();
+        w->stopThread (1000);
+    }
+
+    workers.clear();
+
+    // Workers steal from each other, so they can't start until all are in the array
+    for (int i = 0; i < juce::jlimit (0, 64, n); i++)
+        workers.add (new Worker (*this, i));
+
+    for (auto w : workers)
+        w->startThread (juce::Thread::realtimeAudioPriority);
+}
+
+//==============================================================================
+void WorkerPool::run (Batch& b, int numTasks)
+{
+    if (numTasks <= 0)
+        return;
+
+    auto numWorkers = workers.size();
+
+    if (numTasks == 1 || numWorkers == 0)
+    {
+        for (int i = 0; i < numTasks; i++)
+            runTask ({ &b, i });
+        return;
+    }
+
+    // The caller keeps the first share, the rest are dealt out starting at a
+    // different worker each time so instances don't all load the same one
+    auto callerTasks = (numTasks + numWorkers) / (numWorkers + 1);
+    auto start = nextWorker.fetch_add (1) % numWorkers;
+
+    for (int i = callerTasks; i < numTasks; i++)
+    {
+        auto w = workers.getUnchecked ((start + i - callerTasks) % numWorkers);
+
+        if (! w->queue.push ({ &b, i }))
+            runTask ({ &b, i });
+    }
+
+    for (int i = 0; i < std::min (numWorkers, numTasks - callerTasks); i++)
+        workers.getUnchecked ((start + i) % numWorkers)->wake.signal();
+
+    for (int i = 0; i < callerTasks; i++)
+        runTask ({ &b, i });
+
+    // Take back whatever the workers haven't started, then wait for the rest
+    while (b.remaining.load (std::memory_order_acquire) > 0)
+    {
+        Task t;
+        if (steal (t, 0, &b))
+            runTask (t);
+        else
+            std::this_thread::yield();
+    }
+}
+
+bool WorkerPool::steal (Task& t, int from, const Batch* only)
+{
+    auto numWorkers = workers.size();
+
+    for (int i = 0; i < numWorkers; i++)
+        if (workers.getUnchecked ((from + i) % numWorkers)->queue.stealFront (t, only))
+            return true;
+
+    return false;
+}
+
+void WorkerPool::runTask (Task t)
+{
+    t.batch->fn (t.batch->ctx, t.index);
+
+    // The caller may return as soon as this reaches 0, don't touch the batch after
+    t.batch->remaining.fetch_sub (1, std::memory_order_release);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** One set of DSP worker threads for the whole process, so 30 instances in a
+    host share the cores instead of each starting their own threads. Hold it
+    with a juce::SharedResourcePointer.
+
+    parallelFor() deals the tasks out to the workers' own queues, keeps a
+    share for the calling thread, and runs the workers at realtime audio
+    priority. A worker takes from the back of its own queue, and once that's
+    empty steals from the front of the others', whichever instance posted
+    them. A caller that runs out of work steals back its own tasks, so it
+    never waits for more than the tasks already running on other threads.
+    The thread count comes from the workerThreads global setting, 0 turns
+    the pool off.
+*/
+class WorkerPool
+{
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    int getNumThreads() const               { return workers.size(); }
+
+    /** Stops the workers and starts n new ones. Not from the audio thread. */
+    void setNumThreads (int n);
+
+    /** Runs fn (i) for i in 0 to numTasks - 1 across the pool and returns
+        when all of them are done. Doesn't allocate, safe on the audio thread.
+    */
+    template <typename Fn>
+    void parallelFor (int numTasks, Fn&& fn)
+    {
+        using F = typename std::remove_reference<Fn>::type;
+
+        Batch b;
+        b.fn        = [] (void* ctx, int i) { (*static_cast<F*> (ctx)) (i); };
+        b.ctx       = (void*) &fn;
+        b.remaining = numTasks;
+
+        run (b, numTasks);
+    }
+
+private:
+    struct Batch
+    {
+        void (*fn) (void*, int) = nullptr;
+        void* ctx = nullptr;
+        std::atomic<int> remaining { 0 };
+    };
+
+    struct Task
+    {
+        Batch* batch = nullptr;
+        int index = 0;
+    };
+
+    /** A short list guarded by a spin lock, held only to push or pop one task */
+    struct Queue
+    {
+        bool push (Task t);
+        bool popBack (Task& t);
+        bool stealFront (Task& t, const Batch* only = nullptr);
+
+        static constexpr int capacity = 128;
+
+        juce::SpinLock lock;
+        Task tasks[capacity];
+        int first = 0, size = 0;
+    };
+
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (WorkerPool& p, int idx);
+        void run() override;
+
+        WorkerPool& pool;
+        const int idx;
+        Queue queue;
+        juce::WaitableEvent wake;
+    };
+
+    void run (Batch& b, int numTasks);
+    bool steal (Task& t, int from, const Batch* only = nullptr);
+    static void runTask (Task t);
+
+    std::atomic<int> nextWorker { 0 };
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerPool)
+};
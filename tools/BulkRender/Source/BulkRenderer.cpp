@@ -0,0 +1,433 @@
+#include "BulkRenderer.h"
+
+//==============================================================================
+/** Plays from the start at the tempo of the midi file, for tempo synced lfos
+    and delays.
+*/
+class RenderPlayHead : public juce::AudioPlayHead
+{
+public:
+    RenderPlayHead (double bpm_, double sampleRate_)
+        : bpm (bpm_), sampleRate (sampleRate_)
+    {
+    }
+
+    bool getCurrentPosition (CurrentPositionInfo& info) override
+    {
+        info.resetToDefault();
+
+        info.bpm                = bpm;
+        info.timeInSamples      = position;
+        info.timeInSeconds      = double (position) / sampleRate;
+        info.ppqPosition        = info.timeInSeconds * bpm / 60.0;
+        info.isPlaying          = true;
+
+        return true;
+    }
+
+    void advance (int numSamples)   { position += numSamples; }
+
+private:
+    double bpm, sampleRate;
+    juce::int64 position = 0;
+};
+
+//==============================================================================
+class BulkRenderer::Job : public juce::ThreadPoolJob
+{
+public:
+    Job (BulkRenderer& owner_, Result& result_)
+        : juce::ThreadPoolJob (result_.patch + " - " + result_.midi.getFileName()),
+          owner (owner_), result (result_)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        juce::MidiMessageSequence seq;
+        double tempo = 120.0;
+
+        result.error = loadMidi (result.midi, seq, tempo);
+        if (result.error.isNotEmpty())
+            return jobHasFinished;
+
+        auto& proc = owner.acquireProcessor();
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+
+        juce::AudioSampleBuffer buffer;
+
+        if (result.patchFile != juce::File())
+        {
+            // Not prepared, so the state loads straight away
+            proc.releaseResources();
+
+            result.error = loadPatchFile (proc, result.patchFile, owner.initialState);
+            if (result.error.isEmpty())
+                result.error = render (proc, -1, seq, tempo, owner.options, buffer);
+        }
+        else
+        {
+            auto program = findProgram (proc, result.patch);
+            if (program < 0)
+                result.error = "Patch not found";
+            else
+                result.error = render (proc, program, seq, tempo, owner.options, buffer);
+        }
+
+        result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+        result.audioSeconds  = buffer.getNumSamples() / owner.options.sampleRate;
+
+        owner.releaseProcessor (proc);
+
+        if (result.error.isNotEmpty())
+            return jobHasFinished;
+
+        if (owner.options.referenceDir == juce::File())
+        {
+            result.error = writeWav (buffer);
+        }
+        else
+        {
+            result.error = compare (buffer);
+
+            // Keep what it sounds like now, to listen to what changed
+            if (result.error.isNotEmpty() && owner.options.outputDir != juce::File())
+                writeWav (buffer);
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    juce::String compare (const juce::AudioSampleBuffer& buffer)
+    {
+        auto f = owner.options.referenceDir.getChildFile (result.wav.getFileName());
+        if (! f.existsAsFile())
+            return "No reference " + f.getFileName();
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (new juce::FileInputStream (f), true));
+        if (reader == nullptr)
+            return "Can't read reference " + f.getFileName();
+
+        if (reader->sampleRate != owner.options.sampleRate || reader->numChannels != 2)
+            return "Reference has a different format";
+
+        if (reader->lengthInSamples != buffer.getNumSamples())
+            return "Length differs, " + juce::String (buffer.getNumSamples()) + " samples, reference is "
+                    + juce::String (reader->lengthInSamples);
+
+        juce::AudioSampleBuffer reference (2, buffer.getNumSamples());
+        reader->read (&reference, 0, buffer.getNumSamples(), 0, true, true);
+
+        for (int ch = 0; ch < 2; ch++)
+        {
+            auto a = buffer.getReadPointer (ch);
+            auto b = reference.getReadPointer (ch);
+
+            for (int i = 0; i < buffer.getNumSamples(); i++)
+                result.difference = std::max (result.difference, std::abs (a[i] - b[i]));
+        }
+
+        if (result.difference > owner.options.tolerance)
+            return "Differs by " + juce::Decibels::toString (juce::Decibels::gainToDecibels (result.difference));
+
+        return {};
+    }
+
+    juce::String writeWav (const juce::AudioSampleBuffer& buffer)
+    {
+        result.wav.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream> (result.wav);
+        if (stream->failedToOpen())
+            return "Can't write " + result.wav.getFullPathName();
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), owner.options.sampleRate,
+                                                                               2, owner.options.bitDepth, {}, 0));
+        if (writer == nullptr)
+            return "Can't create wav writer";
+
+        stream.release();
+        writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+        return {};
+    }
+
+    BulkRenderer& owner;
+    Result& result;
+};
+
+//==============================================================================
+BulkRenderer::BulkRenderer (const Options& o)
+    : options (o)
+{
+    if (options.numThreads <= 0)
+        options.numThreads = juce::SystemStats::getNumCpus();
+
+    // Created up front on the message thread, the jobs only borrow them
+    for (int i = 0; i < options.numThreads; i++)
+    {
+        auto p = processors.add (new VirtualAnalogAudioProcessor());
+        p->setNonRealtime (true);
+        freeProcessors.add (p);
+    }
+
+    // Patch files are applied on top of this, every processor starts the same
+    processors[0]->getStateInformation (initialState);
+}
+
+BulkRenderer::~BulkRenderer()
+{
+}
+
+juce::Array<BulkRenderer::Result> BulkRenderer::run()
+{
+    // The jobs already keep every core busy, rendering their voices in
+    // parallel as well would only add overhead
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+    workerPool->setNumThreads (0);
+
+    auto patches = options.patches;
+    if (patches.isEmpty() && options.patchFiles.isEmpty())
+        for (int i = 0; i < processors[0]->getNumPrograms(); i++)
+            patches.add (processors[0]->getProgramName (i));
+
+    juce::Array<juce::File> patchFiles;
+    for (int i = 0; i < patches.size(); i++)
+        patchFiles.add ({});
+
+    for (auto& f : options.patchFiles)
+    {
+        patches.add (f.getFileNameWithoutExtension());
+        patchFiles.add (f);
+    }
+
+    if (options.outputDir != juce::File())
+        options.outputDir.createDirectory();
+
+    auto dir = options.outputDir != juce::File() ? options.outputDir : options.referenceDir;
+
+    juce::Array<Result> results;
+    for (int i = 0; i < patches.size(); i++)
+    {
+        auto& patch = patches.getReference (i);
+
+        for (auto& midi : options.midiFiles)
+        {
+            Result r;
+            r.patch     = patch;
+            r.patchFile = patchFiles[i];
+            r.midi      = midi;
+            r.wav       = dir.getChildFile (juce::File::createLegalFileName (patch + " - " + midi.getFileNameWithoutExtension()))
+                             .withFileExtension ("wav");
+            results.add (r);
+        }
+    }
+
+    juce::ThreadPool pool (options.numThreads);
+
+    for (auto& r : results)
+        pool.addJob (new Job (*this, r), true);
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep (50);
+
+    return results;
+}
+
+void BulkRenderer::writeReport (const juce::Array<Result>& results, const juce::File& csv, double wallSeconds)
+{
+    juce::String text = "patch,midi,wav,audio_seconds,render_seconds,realtime_factor,difference_db,error\n";
+
+    double totalAudio = 0.0, totalRender = 0.0;
+    int failed = 0;
+
+    auto quote = [] (const juce::String& s) { return s.quoted(); };
+
+    for (auto& r : results)
+    {
+        auto factor = r.renderSeconds > 0.0 ? r.audioSeconds / r.renderSeconds : 0.0;
+
+        text << quote (r.patch) << "," << quote (r.midi.getFileName()) << "," << quote (r.wav.getFileName()) << ","
+             << juce::String (r.audioSeconds, 3) << "," << juce::String (r.renderSeconds, 3) << ","
+             << juce::String (factor, 1) << "," << juce::String (juce::Decibels::gainToDecibels (r.difference), 1) << ","
+             << quote (r.error) << "\n";
+
+        totalAudio  += r.audioSeconds;
+        totalRender += r.renderSeconds;
+
+        if (r.error.isNotEmpty())
+        {
+            failed++;
+            std::cout << "Failed: " << r.patch << " - " << r.midi.getFileName() << ": " << r.error << std::endl;
+        }
+    }
+
+    if (csv != juce::File())
+        csv.replaceWithText (text);
+
+    std::cout << results.size() - failed << " of " << results.size() << " rendered, "
+              << juce::String (totalAudio, 1) << "s of audio in " << juce::String (wallSeconds, 1) << "s ("
+              << juce::String (wallSeconds > 0.0 ? totalAudio / wallSeconds : 0.0, 1) << "x realtime, "
+              << juce::String (totalRender > 0.0 ? totalAudio / totalRender : 0.0, 1) << "x per job)" << std::endl;
+}
+
+//==============================================================================
+juce::String BulkRenderer::render (VirtualAnalogAudioProcessor& proc, int program, const juce::MidiMessageSequence& seq,
+                                   double tempo, const Options& o, juce::AudioSampleBuffer& out)
+{
+    // Not prepared, so the patch loads straight away rather than fading
+    proc.releaseResources();
+    if (program >= 0)
+        proc.setCurrentProgram (program);
+
+    // Anything still sounding from the last job would leak into this one
+    proc.turnOffAllVoices (false);
+
+    proc.setPlayConfigDetails (0, 2, o.sampleRate, o.blockSize);
+    proc.prepareToPlay (o.sampleRate, o.blockSize);
+    proc.reset();
+
+    RenderPlayHead playHead (tempo, o.sampleRate);
+    proc.setPlayHead (&playHead);
+
+    auto lastEvent  = juce::roundToInt (seq.getEndTime() * o.sampleRate);
+    auto maxSamples = lastEvent + juce::roundToInt (o.maxTail * o.sampleRate);
+    auto silence    = juce::roundToInt (0.5 * o.sampleRate);
+
+    out.setSize (2, maxSamples + o.blockSize);
+    out.clear();
+
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+    int pos = 0, silent = 0;
+
+    while (pos < maxSamples && silent < silence)
+    {
+        auto todo = o.blockSize;
+
+        midi.clear();
+        while (nextEvent < seq.getNumEvents())
+        {
+            auto& m = seq.getEventPointer (nextEvent)->message;
+            auto t  = juce::roundToInt (m.getTimeStamp() * o.sampleRate);
+            if (t >= pos + todo)
+                break;
+
+            midi.addEvent (m, juce::jmax (0, t - pos));
+            nextEvent++;
+        }
+
+        juce::AudioSampleBuffer block (out.getArrayOfWritePointers(), 2, pos, todo);
+        proc.processBlock (block, midi);
+
+        playHead.advance (todo);
+        pos += todo;
+
+        if (pos > lastEvent && block.getMagnitude (0, todo) < juce::Decibels::decibelsToGain (-96.0f))
+            silent += todo;
+        else
+            silent = 0;
+    }
+
+    proc.setPlayHead (nullptr);
+    proc.releaseResources();
+
+    out.setSize (2, pos, true);
+    return {};
+}
+
+juce::String BulkRenderer::loadMidi (const juce::File& f, juce::MidiMessageSequence& seq, double& tempo)
+{
+    juce::FileInputStream is (f);
+    if (is.failedToOpen())
+        return "Can't open " + f.getFullPathName();
+
+    juce::MidiFile mf;
+    if (! mf.readFrom (is))
+        return "Not a midi file";
+
+    mf.convertTimestampTicksToSeconds();
+
+    for (int i = 0; i < mf.getNumTracks(); i++)
+        seq.addSequence (*mf.getTrack (i), 0.0);
+
+    seq.updateMatchedPairs();
+
+    juce::MidiMessageSequence tempos;
+    mf.findAllTempoEvents (tempos);
+
+    tempo = 120.0;
+    if (tempos.getNumEvents() > 0)
+        tempo = 60.0 / tempos.getEventPointer (0)->message.getTempoSecondsPerQuarterNote();
+
+    return {};
+}
+
+int BulkRenderer::findProgram (VirtualAnalogAudioProcessor& proc, const juce::String& name)
+{
+    for (int i = 0; i < proc.getNumPrograms(); i++)
+        if (proc.getProgramName (i).equalsIgnoreCase (name))
+            return i;
+
+    return -1;
+}
+
+juce::String BulkRenderer::loadPatchFile (VirtualAnalogAudioProcessor& proc, const juce::File& f,
+                                          const juce::MemoryBlock& initialState)
+{
+    if (! f.existsAsFile())
+        return "Can't open " + f.getFullPathName();
+
+    proc.setStateInformation (initialState.getData(), int (initialState.getSize()));
+
+    for (auto l : juce::StringArray::fromLines (f.loadFileAsString()))
+    {
+        l = l.trim();
+        if (l.isEmpty() || l.startsWithChar ('#'))
+            continue;
+
+        auto uid   = l.upToFirstOccurrenceOf ("=", false, false).trim();
+        auto value = l.fromFirstOccurrenceOf ("=", false, false).trim();
+
+        gin::Parameter* param = nullptr;
+        for (auto pp : proc.getPluginParameters())
+            if (pp->getUid() == uid)
+                param = pp;
+
+        // A renamed parameter has to fail, not quietly render the default
+        if (param == nullptr || value.isEmpty())
+            return "Bad line in " + f.getFileName() + ": " + l;
+
+        param->setUserValue (value.getFloatValue());
+    }
+
+    return {};
+}
+
+//==============================================================================
+VirtualAnalogAudioProcessor& BulkRenderer::acquireProcessor()
+{
+    while (true)
+    {
+        {
+            juce::ScopedLock sl (lock);
+            if (freeProcessors.size() > 0)
+                return *freeProcessors.removeAndReturn (freeProcessors.size() - 1);
+        }
+
+        processorFreed.wait (100);
+    }
+}
+
+void BulkRenderer::releaseProcessor (VirtualAnalogAudioProcessor& proc)
+{
+    {
+        juce::ScopedLock sl (lock);
+        freeProcessors.add (&proc);
+    }
+
+    processorFreed.signal();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../plugin/Source/PluginProcessor.h"
+
+//==============================================================================
+/** Renders every midi file through every patch to wav files, offline and in
+    parallel. Each job runs on its own VirtualAnalogAudioProcessor, there are
+    as many processors as threads and a job borrows whichever is free.
+
+    With a reference folder set, renders are compared against the wav files
+    of the same name in it instead of being written, any render that differs
+    by more than the tolerance is a failure. Renders start from a reset
+    processor so the same patch, midi, sample rate and block size always
+    give the same audio.
+
+    Patches are either programs, or patch files: one uid = value line per
+    parameter, in the parameter's own units, set on top of the state a new
+    processor starts in. Patch files don't depend on what's in the program
+    folder, so they're what the checked in fixtures use.
+*/
+class BulkRenderer
+{
+public:
+    struct Options
+    {
+        juce::StringArray patches;          // program names, empty for all
+        juce::Array<juce::File> patchFiles; // rendered instead of the programs
+        juce::Array<juce::File> midiFiles;
+        juce::File outputDir;
+
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int numThreads = 0;                 // 0 for one per core
+        int bitDepth = 24;
+        double maxTail = 5.0;               // seconds rendered after the last event, at most
+
+        juce::File referenceDir;            // compare against these rather than writing wavs
+        float tolerance = juce::Decibels::decibelsToGain (-100.0f);
+    };
+
+    struct Result
+    {
+        juce::String patch;
+        juce::File patchFile;
+        juce::File midi, wav;
+        double audioSeconds = 0.0;
+        double renderSeconds = 0.0;
+        float difference = 0.0f;            // largest difference from the reference
+        juce::String error;
+    };
+
+    BulkRenderer (const Options& o);
+    ~BulkRenderer();
+
+    /** Renders all the jobs and returns when they're done */
+    juce::Array<Result> run();
+
+    /** Writes one csv line per job and prints a summary */
+    static void writeReport (const juce::Array<Result>& results, const juce::File& csv, double wallSeconds);
+
+    //==============================================================================
+    /** Loads a program and plays a midi sequence through it into out, starting
+        from a freshly reset processor. With program -1 it plays whatever patch
+        is already loaded. The tail stops once the output has been silent for
+        half a second or maxTail is reached.
+    */
+    static juce::String render (VirtualAnalogAudioProcessor& proc, int program, const juce::MidiMessageSequence& seq,
+                                double tempo, const Options& o, juce::AudioSampleBuffer& out);
+
+    static juce::String loadMidi (const juce::File& f, juce::MidiMessageSequence& seq, double& tempo);
+    static int findProgram (VirtualAnalogAudioProcessor& proc, const juce::String& name);
+
+    /** Puts proc back to initialState then sets the parameters in a patch file */
+    static juce::String loadPatchFile (VirtualAnalogAudioProcessor& proc, const juce::File& f,
+                                       const juce::MemoryBlock& initialState);
+
+private:
+    class Job;
+
+    VirtualAnalogAudioProcessor& acquireProcessor();
+    void releaseProcessor (VirtualAnalogAudioProcessor& proc);
+
+    Options options;
+    juce::MemoryBlock initialState;
+
+    juce::CriticalSection lock;
+    juce::WaitableEvent processorFreed;
+    juce::OwnedArray<VirtualAnalogAudioProcessor> processors;
+    juce::Array<VirtualAnalogAudioProcessor*> freeProcessors;
+
+    JUCE_DECLARE_NON_COPYABLE (BulkRenderer)
+};
@@ -0,0 +1,152 @@
+#include <JuceHeader.h>
+#include "BulkRenderer.h"
+
+//==============================================================================
+/** One name or path per line, blank lines and lines starting with # are skipped */
+static juce::StringArray readList (const juce::File& f)
+{
+    juce::StringArray lines;
+    for (auto l : juce::StringArray::fromLines (f.loadFileAsString()))
+    {
+        l = l.trim();
+        if (l.isNotEmpty() && ! l.startsWithChar ('#'))
+            lines.add (l);
+    }
+    return lines;
+}
+
+/** A folder of midi files, or a list of them relative to the list file */
+static juce::Array<juce::File> findMidiFiles (const juce::File& f)
+{
+    juce::Array<juce::File> files;
+
+    if (f.isDirectory())
+    {
+        for (auto entry : juce::RangedDirectoryIterator (f, false, "*.mid;*.midi"))
+            files.add (entry.getFile());
+
+        files.sort();
+    }
+    else
+    {
+        for (auto& l : readList (f))
+            files.add (f.getParentDirectory().getChildFile (l));
+    }
+
+    return files;
+}
+
+static BulkRenderer::Options getOptions (const juce::ArgumentList& args)
+{
+    BulkRenderer::Options o;
+
+    args.failIfOptionIsMissing ("--midi");
+
+    if (args.containsOption ("--patches"))
+    {
+        auto f = args.getFileForOption ("--patches");
+
+        if (f.isDirectory())
+        {
+            for (auto entry : juce::RangedDirectoryIterator (f, false, "*.txt"))
+                o.patchFiles.add (entry.getFile());
+
+            o.patchFiles.sort();
+
+            if (o.patchFiles.isEmpty())
+                juce::ConsoleApplication::fail ("No patch files");
+        }
+        else
+        {
+            o.patches = readList (args.getExistingFileForOption ("--patches"));
+        }
+    }
+
+    o.midiFiles = findMidiFiles (args.getFileForOption ("--midi"));
+    if (args.containsOption ("--out"))
+        o.outputDir = args.getFileForOption ("--out");
+
+    if (args.containsOption ("--rate"))     o.sampleRate = args.getValueForOption ("--rate").getDoubleValue();
+    if (args.containsOption ("--block"))    o.blockSize  = args.getValueForOption ("--block").getIntValue();
+    if (args.containsOption ("--threads"))  o.numThreads = args.getValueForOption ("--threads").getIntValue();
+    if (args.containsOption ("--bits"))     o.bitDepth   = args.getValueForOption ("--bits").getIntValue();
+    if (args.containsOption ("--tail"))     o.maxTail    = args.getValueForOption ("--tail").getDoubleValue();
+
+    if (o.midiFiles.isEmpty())
+        juce::ConsoleApplication::fail ("No midi files");
+    if (o.sampleRate < 8000.0 || o.blockSize < 1)
+        juce::ConsoleApplication::fail ("Bad sample rate or block size");
+
+    return o;
+}
+
+/** Renders, writes the report and sets the exit code from the results */
+static void runRender (const BulkRenderer::Options& o)
+{
+    auto start = juce::Time::getMillisecondCounterHiRes();
+
+    BulkRenderer renderer (o);
+    auto results = renderer.run();
+
+    auto wall = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+    auto csv = o.outputDir != juce::File() ? o.outputDir.getChildFile ("report.csv") : juce::File();
+    BulkRenderer::writeReport (results, csv, wall);
+
+    for (auto& r : results)
+        if (r.error.isNotEmpty())
+            juce::ConsoleApplication::fail ({}, 1);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage:", true);
+
+    app.addCommand ({ "--render",
+                      "--render --midi=<folder or list> --out=<folder> [--patches=<folder or list>] [--rate=48000] [--block=512] [--threads=n] [--bits=24] [--tail=5]",
+                      "Renders every midi file through every patch",
+                      "Patches are a list of program names or a folder of patch files, without --patches every program is rendered. "
+                      "Writes one wav per pair and report.csv with the render times to the output folder.",
+                      [] (const juce::ArgumentList& args)
+                      {
+                          args.failIfOptionIsMissing ("--out");
+                          runRender (getOptions (args));
+                      }});
+
+    app.addCommand ({ "--golden",
+                      "--golden --midi=<folder or list> --out=<folder> [--patches=<folder or list>] [--rate=48000] [--block=512]",
+                      "Renders reference files for --verify",
+                      "Same as --render, but always writes 32 bit float wavs so nothing is lost to dither or rounding.",
+                      [] (const juce::ArgumentList& args)
+                      {
+                          args.failIfOptionIsMissing ("--out");
+
+                          auto o = getOptions (args);
+                          o.bitDepth = 32;
+                          runRender (o);
+                      }});
+
+    app.addCommand ({ "--verify",
+                      "--verify=<reference folder> --midi=<folder or list> [--patches=<folder or list>] [--rate=48000] [--block=512] [--tolerance=-100] [--out=<folder>]",
+                      "Checks renders still match the reference files",
+                      "Renders the same way as --golden and compares every render with the reference wav of the same name. "
+                      "Use the patches, midi, rate and block size the references were made with. Exits with 1 if any render "
+                      "differs by more than the tolerance in dB, with --out the renders that differ are written there.",
+                      [] (const juce::ArgumentList& args)
+                      {
+                          auto o = getOptions (args);
+                          o.bitDepth     = 32;
+                          o.referenceDir = args.getExistingFolderForOption ("--verify");
+
+                          if (args.containsOption ("--tolerance"))
+                              o.tolerance = juce::Decibels::decibelsToGain (args.getValueForOption ("--tolerance").getFloatValue());
+
+                          runRender (o);
+                      }});
+
+    return app.findAndRunCommand (argc, argv);
+}
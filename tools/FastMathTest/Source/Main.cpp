@@ -0,0 +1,175 @@
+#include <JuceHeader.h>
+#include "../../../plugin/Source/FastMath.h"
+
+//==============================================================================
+/** Checks FastMath against the std versions, in double, over every range the
+    synth uses it for. Inputs are rounded to float first so only FastMath's
+    own error is measured.
+*/
+class FastMathTests : public juce::UnitTest
+{
+public:
+    FastMathTests() : juce::UnitTest ("FastMath") {}
+
+    void runTest() override
+    {
+        beginTest ("exp2");
+        {
+            double worst = 0.0;
+            for (double x = -126.0; x <= 127.0; x += 0.0007)
+            {
+                auto xf  = float (x);
+                auto ref = std::exp2 (double (xf));
+                worst = std::max (worst, std::abs (FastMath::exp2 (xf) - ref) / ref);
+            }
+            expectLessThan (worst, 3e-7);
+
+            expect (std::isfinite (FastMath::exp2 (1000.0f)));
+            expectEquals (FastMath::exp2 (0.0f), 1.0f);
+        }
+
+        beginTest ("log2");
+        {
+            double worst = 0.0;
+            for (double e = -125.0; e <= 127.0; e += 0.0007)
+            {
+                auto x   = float (std::exp2 (e));
+                auto ref = std::log2 (double (x));
+                worst = std::max (worst, std::abs (FastMath::log2 (x) - ref) / std::max (1.0, std::abs (ref)));
+            }
+            expectLessThan (worst, 3e-7);
+        }
+
+        beginTest ("noteToHz and hzToNote");
+        {
+            double worstCents = 0.0;
+            for (double n = -20.0; n <= 160.0; n += 0.001)
+            {
+                auto nf  = float (n);
+                auto ref = 440.0 * std::exp2 ((double (nf) - 69.0) / 12.0);
+                worstCents = std::max (worstCents, std::abs (1200.0 * std::log2 (FastMath::noteToHz (nf) / ref)));
+            }
+            expectLessThan (worstCents, 0.002);
+
+            worstCents = 0.0;
+            for (double hz = 4.0; hz <= 24000.0; hz *= 1.0001)
+            {
+                auto hf  = float (hz);
+                auto ref = 69.0 + 12.0 * std::log2 (double (hf) / 440.0);
+                worstCents = std::max (worstCents, 100.0 * std::abs (FastMath::hzToNote (hf) - ref));
+            }
+            expectLessThan (worstCents, 0.002);
+        }
+
+        beginTest ("dbToGain and gainToDb");
+        {
+            double worst = 0.0;
+            for (double db = -99.9; db <= 24.0; db += 0.001)
+            {
+                auto df  = float (db);
+                auto ref = std::pow (10.0, double (df) / 20.0);
+                worst = std::max (worst, std::abs (20.0 * std::log10 (FastMath::dbToGain (df) / ref)));
+            }
+            expectLessThan (worst, 0.00001);
+
+            worst = 0.0;
+            for (double e = -16.0; e <= 4.0; e += 0.0001)
+            {
+                auto g   = float (std::exp2 (e));
+                auto ref = 20.0 * std::log10 (double (g));
+                worst = std::max (worst, std::abs (FastMath::gainToDb (g) - ref));
+            }
+            expectLessThan (worst, 0.00001);
+
+            // Same edges as juce::Decibels
+            expectEquals (FastMath::dbToGain (-100.0f), 0.0f);
+            expectEquals (FastMath::dbToGain (-120.0f), 0.0f);
+            expectEquals (FastMath::gainToDb (0.0f), -100.0f);
+            expectEquals (FastMath::gainToDb (1e-9f), -100.0f);
+            expectEquals (FastMath::gainToDb (0.0f, -96.0f), -96.0f);
+        }
+
+        beginTest ("tanh");
+        {
+            double worst = 0.0;
+            for (double x = -12.0; x <= 12.0; x += 0.0001)
+            {
+                auto xf = float (x);
+                worst = std::max (worst, std::abs (FastMath::tanh (xf) - std::tanh (double (xf))));
+            }
+            expectLessThan (worst, 3e-7);
+
+            expectEquals (FastMath::tanh (0.0f), 0.0f);
+        }
+
+        beginTest ("Arrays");
+        {
+            // An odd length, so the part after the last whole register is checked too
+            constexpr int num = 100003;
+            std::vector<float> in (num), out (num);
+
+            auto fill = [&] (double start, double end)
+            {
+                for (int i = 0; i < num; i++)
+                    in[size_t (i)] = float (start + (end - start) * i / (num - 1));
+            };
+
+            auto worstOf = [&] (auto ref, auto error)
+            {
+                double worst = 0.0;
+                for (int i = 0; i < num; i++)
+                    worst = std::max (worst, error (double (out[size_t (i)]), ref (double (in[size_t (i)]))));
+                return worst;
+            };
+
+            auto cents = [] (double a, double b) { return std::abs (1200.0 * std::log2 (a / b)); };
+            auto db    = [] (double a, double b) { return std::abs (20.0 * std::log10 (a / b)); };
+            auto diff  = [] (double a, double b) { return std::abs (a - b); };
+
+            fill (-20.0, 160.0);
+            FastMath::noteToHz (in.data(), out.data(), num);
+            expectLessThan (worstOf ([] (double n) { return 440.0 * std::exp2 ((n - 69.0) / 12.0); }, cents), 0.002);
+
+            fill (-99.9, 24.0);
+            FastMath::dbToGain (in.data(), out.data(), num);
+            expectLessThan (worstOf ([] (double d) { return std::pow (10.0, d / 20.0); }, db), 0.00001);
+
+            for (int i = 0; i < num; i++)
+                in[size_t (i)] = float (std::exp2 (-16.0 + 20.0 * i / (num - 1)));
+            FastMath::gainToDb (in.data(), out.data(), num);
+            expectLessThan (worstOf ([] (double g) { return 20.0 * std::log10 (g); }, diff), 0.00001);
+
+            fill (-12.0, 12.0);
+            FastMath::tanh (in.data(), out.data(), num);
+            expectLessThan (worstOf ([] (double x) { return std::tanh (x); }, diff), 3e-7);
+
+            // The same edges as one at a time, in every lane
+            float edges[] = { -100.0f, -120.0f, 0.0f, -100.0f, -120.0f };
+            FastMath::dbToGain (edges, edges, 5);
+            float expected[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+            for (int i = 0; i < 5; i++)
+                expectEquals (edges[i], expected[i]);
+
+            float gains[] = { 0.0f, 1e-9f, 0.0f, 1e-9f, 0.0f };
+            FastMath::gainToDb (gains, gains, 5, -96.0f);
+            for (auto g : gains)
+                expectEquals (g, -96.0f);
+        }
+    }
+};
+
+static FastMathTests fastMathTests;
+
+//==============================================================================
+int main (int, char*[])
+{
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+    runner.runAllTests();
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); i++)
+        failures += runner.getResult (i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}